@@ -24,6 +24,13 @@ Version 3. (See accompanying file License.txt)
 // Local frameworks
 #include "brown_path_increments.h"
 #include "memfile.h"
+#include "makebm.h"
+#include "algebra_file.h"
+#include "feature_matrix.h"
+#include "golden_files.h"
+#include "streaming_signature.h"
+#include "mapped_tensor.h"
+#include "SigHelpers.h"
 #include "time_and_details.h"
 
 typedef brown_path_increments<5, 5, 60> pathsetup5560;
@@ -54,6 +61,44 @@ TEST_FIXTURE(pathsetup5560, logsignature_versus_cbh)
 	CHECK_EQUAL(logsig1.size(), 829);
 }
 
+TEST_FIXTURE(pathsetup5560, fused_logsignature_versus_cbh)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	TENSOR sig = signature(begin, end);
+
+	std::vector<const LIE*> vec_of_ptr_to_lie;
+	for (std::vector<LIE>::const_iterator i = increments.cbegin(); i != increments.cend(); i++)
+		vec_of_ptr_to_lie.push_back(&(*i));
+	LIE logsig = cbh.full(vec_of_ptr_to_lie);
+
+	LIE logsig1, logsig2, logsig3;
+	std::cout << "maps.t2l(log(sig)): ";
+	{
+		timer log_t;
+		logsig1 = maps.t2l(log(sig));
+	}
+	std::cout << "graded log and projection: ";
+	{
+		timer log_t;
+		logsig2 = ::lie_log(sig, *this);
+	}
+	std::cout << "dense signature, graded log and projection: ";
+	{
+		timer log_t;
+		logsig3 = ::fused_logsignature(begin, end, *this);
+	}
+	for (auto k : LIE(logsig - logsig1))
+		CHECK_CLOSE(k.second, 0., 7.0e-16);
+	for (auto k : LIE(logsig - logsig2))
+		CHECK_CLOSE(k.second, 0., 7.0e-16);
+	for (auto k : LIE(logsig - logsig3))
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	CHECK_EQUAL(logsig2.size(), 829);
+	CHECK_EQUAL(logsig3.size(), 829);
+}
+
 TEST_FIXTURE(pathsetup5560, simple_multiplication)
 {
 	TEST_DETAILS();
@@ -96,4 +141,417 @@ TEST_FIXTURE(pathsetup5560, fine_changes_to_arithmetic_using_memory_mapped_file)
 
 	LIE logsig = logsignature(cbegin_framework, cend_framework);
 	CHECK_compare_with_file(logsig, "logsignature.raw");
+}
+
+TEST_FIXTURE(pathsetup5560, out_of_core_signature_using_memory_mapped_levels)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	TENSOR sig = signature(begin, end);
+
+	// the levels of the signature live in memory mapped files
+	mapped_tensor<S, ALPHABET_SIZE, DEPTH> mapped_sig("mapped_signature");
+	mapped_signature(begin, end, *this, mapped_sig);
+
+	TENSOR err = sig - mapped_sig.to_tensor<TENSOR>();
+	for (auto k : err) {
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	}
+
+	// the dense product of mapped tensors agrees with the sparse product
+	mapped_tensor<S, ALPHABET_SIZE, DEPTH> lhs("mapped_lhs"), rhs("mapped_rhs"), product("mapped_product");
+	lhs.assign(signature(begin, begin + (end - begin) / 2));
+	rhs.assign(signature(begin + (end - begin) / 2, end));
+	multiply(lhs, rhs, product);
+	err = sig - product.to_tensor<TENSOR>();
+	for (auto k : err) {
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	}
+
+	// squaring in place
+	const TENSOR half = lhs.to_tensor<TENSOR>();
+	lhs *= lhs;
+	err = half * half - lhs.to_tensor<TENSOR>();
+	for (auto k : err) {
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	}
+}
+
+TEST_FIXTURE(pathsetup5560, in_place_level_streaming_products)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	TENSOR sig = signature(begin, end);
+
+	// the signature accumulated in place
+	TENSOR err = sig - ::inplace_signature(begin, end, *this);
+	for (auto k : err) {
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	}
+
+	// the in place dense product agrees with the sparse product
+	typedef dense_tensor<S, ALPHABET_SIZE, DEPTH> DENSE;
+	DENSE lhs, rhs;
+	lhs.assign(signature(begin, begin + (end - begin) / 2));
+	rhs.assign(signature(begin + (end - begin) / 2, end));
+	lhs *= rhs;
+	err = sig - lhs.to_tensor<TENSOR>();
+	for (auto k : err) {
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	}
+
+	// squaring in place
+	DENSE square(rhs);
+	square *= square;
+	err = signature(begin + (end - begin) / 2, end) * signature(begin + (end - begin) / 2, end) - square.to_tensor<TENSOR>();
+	for (auto k : err) {
+		CHECK_CLOSE(k.second, 0., 2.0e-15);
+	}
+}
+
+TEST_FIXTURE(pathsetup5560, random_projection_sketch_of_signature)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	TENSOR sig = signature(begin, end);
+
+	// the same seed gives the same functionals
+	signature_sketch<ALPHABET_SIZE, DEPTH> sketch(200), same(200), other(200, 1234u);
+	std::vector<double> values = ::sketch_signature(begin, end, *this, sketch);
+	CHECK_EQUAL(sketch.size(), values.size());
+	CHECK(values == ::sketch_signature(begin, end, *this, same));
+	CHECK(values != ::sketch_signature(begin, end, *this, other));
+
+	// propagating the sketch agrees with sketching the full signature
+	std::vector<double> expected = sketch.apply(sig);
+	for (size_t i = 0; i < values.size(); ++i)
+		CHECK_CLOSE(expected[i], values[i], 1.0e-12);
+
+	// an increment with a bracket component cannot be carried by degree one updates
+	std::vector<LIE> bracketed(begin, end);
+	bracketed.back() += LIE(1, S(1)) * LIE(2, S(1));
+	CHECK_THROW(::sketch_signature(bracketed.cbegin(), bracketed.cend(), *this, sketch), std::invalid_argument);
+}
+
+TEST_FIXTURE(pathsetup5560, raw_strided_path_ingestion)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	const size_t steps = end - begin;
+	TENSOR sig = signature(begin, end);
+	LIE logsig = maps.t2l(log(sig));
+
+	// the makebm path behind the increments, and its increments interleaved with two unused columns
+	std::vector<double> path;
+	makebm(path, steps, ALPHABET_SIZE);
+	const size_t stride = ALPHABET_SIZE + 2;
+	std::vector<double> padded(steps * stride, -1.);
+	for (size_t i = 0; i < steps; ++i)
+		for (size_t j = 0; j < ALPHABET_SIZE; ++j)
+			padded[i * stride + j] = path[(i + 1) * ALPHABET_SIZE + j] - path[i * ALPHABET_SIZE + j];
+
+	TENSOR raw;
+	std::cout << "signature of the raw path: ";
+	{
+		timer raw_t;
+		raw = ::raw_signature(path.data(), steps, ALPHABET_SIZE, *this);
+	}
+	CHECK_CLOSE(0., (raw - sig).NormL1(), 1.0e-12);
+	CHECK_CLOSE(0., (::raw_increments_signature(padded.data(), steps, stride, *this) - sig).NormL1(), 1.0e-12);
+	CHECK_CLOSE(0., (::raw_logsignature(path.data(), steps, ALPHABET_SIZE, *this) - logsig).NormL1(), 1.0e-12);
+	CHECK_CLOSE(0., (::raw_increments_logsignature(padded.data(), steps, stride, *this) - logsig).NormL1(), 1.0e-12);
+}
+
+TEST_FIXTURE(pathsetup5560, memory_mapped_path_file_windows)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	const size_t steps = end - begin;
+	TENSOR sig = signature(begin, end);
+
+	std::vector<double> path;
+	makebm(path, steps, ALPHABET_SIZE);
+	write_path_file("brownian.path", path.data(), steps, ALPHABET_SIZE);
+	{
+		path_file file("brownian.path");
+		CHECK_EQUAL(size_t(ALPHABET_SIZE), file.width());
+		CHECK_EQUAL(steps, file.steps());
+		CHECK(std::equal(path.begin() + 3 * ALPHABET_SIZE, path.begin() + 5 * ALPHABET_SIZE, file.window(3, 2)));
+
+		// windows of 7 increments, so the path crosses many window boundaries
+		CHECK_CLOSE(0., (::path_file_signature(file, *this, 7) - sig).NormL1(), 1.0e-12);
+		CHECK_CLOSE(0., (::path_file_signature(file, *this) - sig).NormL1(), 1.0e-12);
+		CHECK_CLOSE(0., (::path_file_logsignature(file, *this, 7) - maps.t2l(log(sig))).NormL1(), 1.0e-12);
+	}
+	boost::filesystem::remove("brownian.path");
+}
+
+TEST_FIXTURE(pathsetup5560, versioned_binary_serialization)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	TENSOR sig = signature(begin, end);
+	LIE logsig = maps.t2l(log(sig));
+
+	save_tensor<ALPHABET_SIZE, DEPTH>(sig, "signature.dense.alg", algebra_file::DENSE);
+	save_tensor<ALPHABET_SIZE, DEPTH>(sig, "signature.sparse.alg", algebra_file::SPARSE);
+	save_lie<ALPHABET_SIZE, DEPTH>(logsig, "logsignature.dense.alg", algebra_file::DENSE);
+	save_lie<ALPHABET_SIZE, DEPTH>(logsig, "logsignature.sparse.alg", algebra_file::SPARSE);
+	{
+		algebra_view dense("signature.dense.alg"), sparse("signature.sparse.alg");
+		CHECK_EQUAL(uint32_t(ALPHABET_SIZE), dense.header().width);
+		CHECK_EQUAL(uint32_t(DEPTH), dense.header().depth);
+		CHECK_EQUAL(TENSOR::basis.size(), dense.count());
+		CHECK_EQUAL(sig.size(), sparse.count());
+		CHECK(sig == (load_tensor<ALPHABET_SIZE, DEPTH, TENSOR>(dense)));
+		CHECK(sig == (load_tensor<ALPHABET_SIZE, DEPTH, TENSOR>(sparse)));
+
+		// the mapped data is read in place
+		if (algebra_file::native_little_endian()) {
+			typedef tensor_layout<ALPHABET_SIZE, DEPTH> LAYOUT;
+			for (auto k : sig)
+				CHECK_EQUAL(double(k.second), dense.dense()[LAYOUT::index<TENSOR>(k.first)]);
+			CHECK(sparse.sparse() != nullptr && dense.sparse() == nullptr);
+		}
+
+		algebra_view lie_dense("logsignature.dense.alg"), lie_sparse("logsignature.sparse.alg");
+		CHECK_EQUAL(LIE::basis.size(), lie_dense.count());
+		CHECK(logsig == (load_lie<ALPHABET_SIZE, DEPTH, LIE>(lie_dense)));
+		CHECK(logsig == (load_lie<ALPHABET_SIZE, DEPTH, LIE>(lie_sparse)));
+		CHECK_THROW((load_lie<ALPHABET_SIZE, DEPTH, LIE>(dense)), std::runtime_error);
+	}
+
+	// corrupt or foreign files are rejected rather than read out of bounds
+	boost::filesystem::remove("truncated.alg");
+	boost::filesystem::copy_file("signature.sparse.alg", "truncated.alg");
+	boost::filesystem::resize_file("truncated.alg", boost::filesystem::file_size("truncated.alg") - 8);
+	CHECK_THROW(algebra_view("truncated.alg"), std::runtime_error);
+	std::vector<algebra_file_entry> entries{ { 0, 1. }, { TENSOR::basis.size(), 1. } };
+	algebra_file::write("out_of_range.alg", algebra_file::TENSOR_KIND, algebra_file::SPARSE, ALPHABET_SIZE, DEPTH, TENSOR::basis.size(), entries);
+	CHECK_THROW(algebra_view("out_of_range.alg"), std::runtime_error);
+	entries.pop_back();
+	algebra_file::write("foreign.alg", algebra_file::TENSOR_KIND, algebra_file::DENSE, ALPHABET_SIZE, DEPTH, TENSOR::basis.size() + 1, entries);
+	{
+		algebra_view foreign("foreign.alg");
+		CHECK_THROW((load_tensor<ALPHABET_SIZE, DEPTH, TENSOR>(foreign)), std::runtime_error);
+	}
+	for (auto name : { "signature.dense.alg", "signature.sparse.alg", "logsignature.dense.alg", "logsignature.sparse.alg"
+		, "truncated.alg", "out_of_range.alg", "foreign.alg" })
+		boost::filesystem::remove(name);
+}
+
+TEST_FIXTURE(pathsetup5560, logsignature_features_in_a_memory_mapped_matrix)
+{
+	TEST_DETAILS();
+	const size_t steps = increments.size(), n_paths = 16;
+	// n_paths makebm paths side by side, the first being the path of the fixture
+	std::vector<double> paths, path;
+	for (size_t p = 0; p < n_paths; ++p) {
+		makebm(path, steps, ALPHABET_SIZE, (const unsigned int&)0x6d35f0e5b8f6c603 + unsigned(p));
+		paths.insert(paths.end(), path.begin(), path.end());
+	}
+	{
+		feature_matrix logsigs("logsignatures.f32", n_paths, LIE::basis.size());
+		feature_matrix sigs("signatures.f32", n_paths, TENSOR::basis.size());
+		std::cout << "exporting " << n_paths << " logsignatures: ";
+		{
+			timer export_t;
+			export_features(paths.data(), n_paths, steps, *this, logsigs, 0, true);
+		}
+		export_features(paths.data(), n_paths, steps, *this, sigs, 0, false);
+		write_feature_labels("logsignatures.f32.columns", lie_feature_labels<LIE>());
+
+		TENSOR sig = signature(increments.cbegin(), increments.cend());
+		LIE logsig = maps.t2l(log(sig));
+		for (auto k : logsig)
+			CHECK_CLOSE(double(k.second), double(logsigs.row(0)[k.first - 1]), 1.0e-6);
+		typedef tensor_layout<ALPHABET_SIZE, DEPTH> LAYOUT;
+		const size_t last = n_paths - 1;
+		TENSOR sig_last = ::raw_signature(&paths[last * (steps + 1) * ALPHABET_SIZE], steps, ALPHABET_SIZE, *this);
+		for (auto k : sig_last)
+			CHECK_CLOSE(double(k.second), double(sigs.row(last)[LAYOUT::index<TENSOR>(k.first)]), 1.0e-6);
+		write_feature_labels("signatures.f32.columns", tensor_feature_labels<ALPHABET_SIZE, DEPTH, TENSOR>());
+
+		// a batch of precomputed signatures gives the same rows
+		std::vector<TENSOR> batch;
+		for (size_t p = 0; p < n_paths; ++p)
+			batch.push_back(::raw_signature(&paths[p * (steps + 1) * ALPHABET_SIZE], steps, ALPHABET_SIZE, *this));
+		feature_matrix batch_logsigs("batch_logsignatures.f32", n_paths, LIE::basis.size());
+		feature_matrix batch_sigs("batch_signatures.f32", n_paths, TENSOR::basis.size());
+		export_features(batch.cbegin(), batch.cend(), *this, batch_logsigs, 0, true);
+		export_features(batch.cbegin(), batch.cend(), *this, batch_sigs, 0, false);
+		for (size_t p = 0; p < n_paths; ++p) {
+			for (size_t c = 0; c < LIE::basis.size(); ++c)
+				CHECK_CLOSE(logsigs.row(p)[c], batch_logsigs.row(p)[c], 1.0e-6);
+			for (size_t c = 0; c < TENSOR::basis.size(); ++c)
+				CHECK_CLOSE(sigs.row(p)[c], batch_sigs.row(p)[c], 1.0e-6);
+		}
+	}
+	// the sidecars have one label per column
+	boost::filesystem::ifstream labels("logsignatures.f32.columns");
+	std::string label;
+	size_t columns = 0;
+	while (std::getline(labels, label))
+		CHECK_EQUAL(LIE::basis.key2string(++columns), label);
+	CHECK_EQUAL(LIE::basis.size(), columns);
+	labels.close();
+	std::vector<std::string> tensor_labels;
+	boost::filesystem::ifstream tensor_columns("signatures.f32.columns");
+	while (std::getline(tensor_columns, label))
+		tensor_labels.push_back(label);
+	tensor_columns.close();
+	CHECK_EQUAL(TENSOR::basis.size(), tensor_labels.size());
+	// the first word of each degree, 1...1, heads its columns
+	typedef tensor_layout<ALPHABET_SIZE, DEPTH> LAYOUT;
+	TENSOR::KEY word;
+	for (unsigned d = 0; d <= DEPTH; word = word * TENSOR::basis.keyofletter(1), ++d)
+		CHECK_EQUAL(TENSOR::basis.key2string(word), tensor_labels[LAYOUT::offset(d)]);
+	for (auto name : { "logsignatures.f32", "signatures.f32", "logsignatures.f32.columns", "signatures.f32.columns"
+		, "batch_logsignatures.f32", "batch_signatures.f32" })
+		boost::filesystem::remove(name);
+}
+
+TEST_FIXTURE(pathsetup5560, tolerance_aware_comparison_with_golden_files)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	TENSOR sig = signature(begin, end);
+	LIE logsig = maps.t2l(log(sig));
+
+	// raw golden files, made by the first comparison as by CHECK_compare_with_file and read by the others
+	for (auto name : { "signature.golden.raw", "logsignature.golden.raw" })
+		boost::filesystem::remove(name);
+	CHECK_compare_with_file_close(sig, "signature.golden.raw", 1.0e-15);
+	CHECK_compare_with_file_close(sig, "signature.golden.raw", 1.0e-15);
+	CHECK_compare_with_file_close(logsig, "logsignature.golden.raw", 1.0e-15);
+	LIE perturbed = logsig + LIE(2, S(1.0e-9));
+	file_deviation deviation = deviation_from_file(perturbed, "logsignature.golden.raw");
+	CHECK_CLOSE(1.0e-9, deviation.max, 1.0e-15);
+	CHECK(deviation.within(1.0e-8) && !deviation.within(1.0e-10));
+	CHECK_EQUAL(logsig.size(), deviation.compared);
+
+	// algebra files in both encodings, with a coordinate missing from the computed vector
+	save_tensor<ALPHABET_SIZE, DEPTH>(sig, "signature.golden.dense.alg", algebra_file::DENSE);
+	save_tensor<ALPHABET_SIZE, DEPTH>(sig, "signature.golden.sparse.alg", algebra_file::SPARSE);
+	{
+		algebra_view dense("signature.golden.dense.alg"), sparse("signature.golden.sparse.alg");
+		CHECK_EQUAL(0., (tensor_deviation_from_file<ALPHABET_SIZE, DEPTH>(sig, dense).max));
+		CHECK_EQUAL(0., (tensor_deviation_from_file<ALPHABET_SIZE, DEPTH>(sig, sparse).max));
+		const auto k = *sig.begin();
+		TENSOR missing = sig - TENSOR(k.first, k.second);
+		deviation = tensor_deviation_from_file<ALPHABET_SIZE, DEPTH>(missing, sparse);
+		CHECK_EQUAL(std::fabs(double(k.second)), deviation.max);
+		CHECK_EQUAL(sig.size(), deviation.compared);
+		CHECK_EQUAL(std::fabs(double(k.second)), (tensor_deviation_from_file<ALPHABET_SIZE, DEPTH>(missing, dense).max));
+
+		// and a computed coordinate missing from the file
+		save_tensor<ALPHABET_SIZE, DEPTH>(missing, "missing.golden.sparse.alg", algebra_file::SPARSE);
+		algebra_view short_file("missing.golden.sparse.alg");
+		deviation = tensor_deviation_from_file<ALPHABET_SIZE, DEPTH>(sig, short_file);
+		CHECK_EQUAL(std::fabs(double(k.second)), deviation.max);
+		CHECK_EQUAL(sig.size(), deviation.compared);
+	}
+	save_lie<ALPHABET_SIZE, DEPTH>(logsig, "logsignature.golden.dense.alg", algebra_file::DENSE);
+	save_lie<ALPHABET_SIZE, DEPTH>(logsig, "logsignature.golden.sparse.alg", algebra_file::SPARSE);
+	{
+		algebra_view dense("logsignature.golden.dense.alg"), sparse("logsignature.golden.sparse.alg");
+		CHECK_EQUAL(0., (lie_deviation_from_file<ALPHABET_SIZE, DEPTH>(logsig, dense).max));
+		CHECK_EQUAL(0., (lie_deviation_from_file<ALPHABET_SIZE, DEPTH>(logsig, sparse).max));
+		deviation = lie_deviation_from_file<ALPHABET_SIZE, DEPTH>(perturbed, sparse);
+		CHECK_CLOSE(1.0e-9, deviation.max, 1.0e-15);
+		CHECK_EQUAL(logsig.size(), deviation.compared);
+		CHECK_THROW((lie_deviation_from_file<ALPHABET_SIZE, DEPTH>(logsig, (algebra_view("signature.golden.sparse.alg")))), std::runtime_error);
+	}
+	for (auto name : { "signature.golden.dense.alg", "signature.golden.sparse.alg", "missing.golden.sparse.alg"
+		, "logsignature.golden.dense.alg", "logsignature.golden.sparse.alg", "signature.golden.raw", "logsignature.golden.raw" })
+		boost::filesystem::remove(name);
+}
+
+TEST_FIXTURE(pathsetup5560, streaming_signature_with_latency_histogram)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	const size_t steps = end - begin;
+
+	std::vector<double> path;
+	makebm(path, steps, ALPHABET_SIZE);
+	std::vector<double> x(steps * ALPHABET_SIZE);
+	for (size_t i = 0; i < steps * ALPHABET_SIZE; ++i)
+		x[i] = path[i + ALPHABET_SIZE] - path[i];
+
+	streaming_signature<pathsetup5560> stream(*this);
+	for (size_t i = 0; i < steps; ++i) {
+		stream.push(&x[i * ALPHABET_SIZE]);
+		// the logsignature can be read at any step
+		if (i + 1 == steps / 2) {
+			const LIE half = maps.t2l(log(signature(begin, begin + (i + 1))));
+			CHECK_CLOSE(0., (stream.logsignature() - half).NormL1(), 1.0e-12);
+		}
+	}
+	TENSOR sig = signature(begin, end);
+	CHECK_EQUAL(steps, stream.steps());
+	CHECK_CLOSE(0., (stream.signature().to_tensor<TENSOR>() - sig).NormL1(), 1.0e-12);
+	CHECK_CLOSE(0., (stream.logsignature() - maps.t2l(log(sig))).NormL1(), 1.0e-12);
+
+	// the latency record
+	const latency_histogram& latency = stream.latency();
+	CHECK_EQUAL(uint64_t(steps), latency.count());
+	CHECK(latency.quantile(0.5) <= latency.quantile(0.99) && latency.quantile(0.99) <= latency.max());
+	std::cout << "update latency p50 " << latency.quantile(0.5) << " ns, p99 " << latency.quantile(0.99)
+		<< " ns, max " << latency.max() << " ns" << std::endl;
+
+	// restarting gives the signature of the later increments alone
+	stream.reset();
+	for (size_t i = steps / 2; i < steps; ++i)
+		stream.push(&x[i * ALPHABET_SIZE]);
+	CHECK_CLOSE(0., (stream.signature().to_tensor<TENSOR>() - signature(begin + steps / 2, end)).NormL1(), 1.0e-12);
+	CHECK_EQUAL(uint64_t(steps + steps - steps / 2), latency.count());
+}
+
+TEST_FIXTURE(pathsetup5560, logsignatures_of_every_prefix)
+{
+	TEST_DETAILS();
+	auto begin = increments.cbegin();
+	auto end = increments.cend();
+	const size_t steps = end - begin;
+	const size_t columns = LIE::basis.size();
+
+	std::vector<double> path;
+	makebm(path, steps, ALPHABET_SIZE);
+	std::vector<double> x(steps * ALPHABET_SIZE);
+	for (size_t i = 0; i < steps * ALPHABET_SIZE; ++i)
+		x[i] = path[i + ALPHABET_SIZE] - path[i];
+
+	// every prefix, in small batches
+	std::vector<double> all(steps * columns);
+	std::cout << "logsignatures of " << steps << " prefixes: ";
+	{
+		timer prefixes_t;
+		CHECK_EQUAL(steps, ::prefix_logsignatures(x.data(), steps, ALPHABET_SIZE, 1, *this, all.data(), 16));
+	}
+	for (const size_t n : { size_t(1), size_t(17), steps }) {
+		LIE row;
+		for (size_t k = 0; k < columns; ++k)
+			row += LIE(typename LIE::KEY(k + 1), S(all[(n - 1) * columns + k]));
+		CHECK_CLOSE(0., (row - maps.t2l(log(signature(begin, begin + n)))).NormL1(), 1.0e-12);
+	}
+
+	// every 7th prefix in a feature matrix
+	const size_t rows = prefix_count(steps, 7);
+	{
+		feature_matrix matrix("prefixes.f32", rows, columns);
+		CHECK_EQUAL(rows, ::prefix_logsignatures(x.data(), steps, ALPHABET_SIZE, 7, *this, matrix, 0));
+		for (size_t r = 0; r < rows; ++r)
+			for (size_t k = 0; k < columns; ++k)
+				CHECK_CLOSE(all[(7 * r + 6) * columns + k], double(matrix.row(r)[k]), 1.0e-6);
+	}
+	boost::filesystem::remove("prefixes.f32");
 }
\ No newline at end of file
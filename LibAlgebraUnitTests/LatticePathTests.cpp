@@ -1,6 +1,7 @@
 // FastSigsExp1.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 #include "categorical_path.h"
+#include "SigHelpers.h"
 
 // the unit test framework
 #include <UnitTest++/UnitTest++.h>
@@ -34,6 +35,62 @@ void report_outcomes(const LOGS& logs, const SIG& sig, const FRAMEWORK & context
 		<< "\n\n";
 }
 
+template<typename FRAMEWORK>
+void compare_graded_log(const FRAMEWORK& p)
+{
+	typename FRAMEWORK::TENSOR sig = p.signature(p.begin(), p.end());
+	typename FRAMEWORK::LIE logs1, logs2;
+	std::cout << "maps.t2l(log(sig)): ";
+	{
+		timer log_t;
+		logs1 = p.maps.t2l(log(sig));
+	}
+	std::cout << "graded log and projection: ";
+	{
+		timer log_t;
+		logs2 = ::lie_log(sig, p);
+	}
+	CHECK(logs1 == logs2);
+}
+
+template<typename FRAMEWORK>
+void compare_level_aware_series(const FRAMEWORK& p)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	// the part of the logsignature in degrees >= 2, so that only DEPTH / 2 terms of the series contribute
+	LIE logs = p.maps.t2l(log(p.signature(p.begin(), p.end()))), high;
+	for (const auto& k : logs)
+		if (LIE::basis.degree(k.first) >= 2)
+			high.add_scal_prod(k.first, k.second);
+	const TENSOR x = p.maps.l2t(high);
+	TENSOR g, ans;
+	std::cout << "exp(x): ";
+	{
+		timer exp_t;
+		g = exp(x);
+	}
+	std::cout << "level aware exp(x): ";
+	{
+		timer exp_t;
+		ans = graded_exp(x, FRAMEWORK::DEPTH);
+	}
+	CHECK(g == ans);
+	CHECK(graded_log(g, FRAMEWORK::DEPTH) == log(g));
+	CHECK(graded_log(g, FRAMEWORK::DEPTH) == x);
+	CHECK(graded_exp(TENSOR(), FRAMEWORK::DEPTH) == TENSOR(S(1)));
+	CHECK(graded_log(TENSOR(S(1)), FRAMEWORK::DEPTH) == TENSOR());
+
+	// the dense forms share one scratch tensor
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> d, scratch;
+	d.assign(x);
+	exp_inplace(d, scratch);
+	CHECK(d.template to_tensor<TENSOR>() == g);
+	log_inplace(d, scratch);
+	CHECK(d.template to_tensor<TENSOR>() == x);
+}
+
 SUITE(lattice_paths)
 {
 
@@ -133,6 +190,48 @@ SUITE(lattice_paths)
 		CHECK_EQUAL(960800, categorical_path::TENSOR::basis.size());
 	}
 
+	TEST_FIXTURE(CPD5W5, graded_log_of_lattice_path)
+	{
+		TEST_DETAILS();
+		compare_graded_log(*this);
+	}
+
+	TEST_FIXTURE(CPD5W5, level_aware_exp_and_log)
+	{
+		TEST_DETAILS();
+		compare_level_aware_series(*this);
+	}
+
+	TEST_FIXTURE(CPD3W3, compressed_lattice_path)
+	{
+		TEST_DETAILS();
+		// a long walk on three letters repeats letters often
+		categorical_path walk(300);
+		const compressed_increments<LIE> merged = ::compress_increments(walk.begin(), walk.end(), walk);
+		std::cout << "compression ratio " << merged.ratio() << " (" << merged.original << " -> " << merged.increments.size() << ")\n";
+		CHECK_EQUAL(size_t(300), merged.original);
+		CHECK(merged.ratio() > 1.);
+		for (size_t i = 1; i < merged.increments.size(); ++i)
+			CHECK(!(merged.increments[i - 1] * merged.increments[i] == LIE()));
+		// exact for Rational
+		CHECK(::compressed_signature(walk.begin(), walk.end(), walk) == walk.signature(walk.begin(), walk.end()));
+
+		// runs of one letter, a zero increment and a collinear pair
+		std::vector<LIE> path = { LIE(1, S(1)), LIE(1, S(2)), LIE(), LIE(2, S(1)), LIE(2, S(1)) + LIE(3, S(1))
+			, LIE(2, S(2)) + LIE(3, S(2)), LIE(1, S(1)) };
+		const compressed_increments<LIE> runs = ::compress_increments(path.begin(), path.end(), *this);
+		CHECK_EQUAL(size_t(4), runs.increments.size());
+		CHECK(runs.increments[0] == LIE(1, S(3)));
+		CHECK(runs.increments[2] == LIE(2, S(3)) + LIE(3, S(3)));
+		CHECK(::compressed_signature(path.begin(), path.end(), *this) == ::signature(path.begin(), path.end(), *this));
+	}
+
+	TEST_FIXTURE(CPD7W7, graded_log_of_lattice_path)
+	{
+		TEST_DETAILS();
+		compare_graded_log(*this);
+	}
+
 	TEST_FIXTURE(CPD8W8, short_lattice_path_high_dimension)
 	{
 		categorical_path p;
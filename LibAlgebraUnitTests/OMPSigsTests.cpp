@@ -10,6 +10,14 @@
 #include <vector>
 #include "brown_path_increments.h"
 #include "SigHelpers.h"
+#include "cow_vector.h"
+#include "batch_tensor.h"
+#include "makebm.h"
+#include "categorical_path.h"
+#include "path_trie.h"
+#include "expected_signature.h"
+#include "signature_kernel.h"
+#include <boost/filesystem/operations.hpp> // remove
 #include <iostream>
 
 // validates the hall set and lie multiplication over it
@@ -19,6 +27,8 @@ SUITE(OMP_SIGNATURES)
 	typedef brown_path_increments<6, 5, 50> SETUP65;
 	typedef brown_path_increments<1, 5, 50> SETUP15;
 	typedef brown_path_increments<2, 2, 50> SETUP22;
+	typedef brown_path_increments<6, 2, 50> SETUP62;
+	typedef brown_path_increments<4, 2, 50> SETUP42;
 	TEST_FIXTURE(SETUP65, bm65_test_parallel_signature)
 	{
 		TEST_DETAILS();
@@ -42,4 +52,349 @@ SUITE(OMP_SIGNATURES)
 		//std::cout << sig.NormL1() << " " << (sig - sig12).NormL1() << std::endl;
 		CHECK_CLOSE(0., (sig - sig1).NormL1() + (sig2 - sig1).NormL1(), 10e-13);
 	}
+
+	TEST_FIXTURE(SETUP65, bm65_copy_on_write_signatures)
+	{
+		TEST_DETAILS();
+		TENSOR sig = ::signature(begin(increments), end(increments), *this);
+		const size_t copies = 100;
+		std::cout << "deep copies: ";
+		{
+			timer copy_t;
+			std::vector<TENSOR> deep(copies, sig);
+		}
+		std::cout << "copy-on-write copies: ";
+		cow_vector<TENSOR> shared(sig);
+		std::vector<cow_vector<TENSOR>> handles;
+		{
+			timer copy_t;
+			handles.assign(copies, shared);
+		}
+		// all copies share one instance
+		CHECK_EQUAL(long(copies + 1), shared.use_count());
+		CHECK(handles.back().shares(shared));
+
+		// mutation detaches only the mutated handle
+		handles.back() *= exp(maps.l2t(increments.front()));
+		CHECK(!handles.back().shares(shared));
+		CHECK(handles.front().shares(shared));
+		CHECK(sig == *shared);
+		CHECK_CLOSE(0., (sig * exp(maps.l2t(increments.front())) - *handles.back()).NormL1(), 10e-13);
+
+		// a unique handle releases its value without copying
+		cow_vector<TENSOR> unique(sig);
+		TENSOR released = unique.release();
+		CHECK(sig == released);
+	}
+
+	TEST_FIXTURE(SETUP62, bm62_unrolled_small_shape_signature)
+	{
+		TEST_DETAILS();
+		typedef fast_tensor<S, ALPHABET_SIZE, DEPTH> FAST;
+		CHECK((std::is_same<FAST, small_tensor<S, ALPHABET_SIZE, DEPTH>>::value));
+		CHECK((std::is_same<fast_tensor<S, 5, 6>, dense_tensor<S, 5, 6>>::value));
+		TENSOR sig, sig1;
+		std::cout << "sparse signature: ";
+		{
+			timer seqsig_t;
+			sig = ::signature(begin(increments), end(increments), *this);
+		}
+		std::cout << "unrolled signature: ";
+		{
+			timer seqsig_t;
+			sig1 = ::fast_signature(begin(increments), end(increments), *this);
+		}
+		CHECK_CLOSE(0., (sig - sig1).NormL1(), 10e-13);
+
+		// exp and log of the unrolled kernels against libalgebra
+		FAST s;
+		s.assign(sig);
+		CHECK_CLOSE(0., (log(s).to_tensor<TENSOR>() - log(sig)).NormL1(), 10e-13);
+		FAST x;
+		x.assign(log(sig));
+		CHECK_CLOSE(0., (exp(x).to_tensor<TENSOR>() - sig).NormL1(), 10e-13);
+	}
+
+	TEST_FIXTURE(SETUP42, bm42_batched_signatures_across_paths)
+	{
+		TEST_DETAILS();
+		const size_t steps = 50, batch = 1000;
+		std::vector<double> batch_increments;
+		makebm_batch(batch_increments, steps, ALPHABET_SIZE, batch);
+		batch_tensor<ALPHABET_SIZE, DEPTH> sigs(batch);
+		std::cout << "batch of " << batch << " signatures: ";
+		{
+			timer batch_t;
+			sigs = batch_signature<ALPHABET_SIZE, DEPTH>(batch_increments.data(), steps, batch);
+		}
+		std::cout << "one signature: ";
+		TENSOR sig;
+		{
+			timer seqsig_t;
+			sig = ::signature(begin(increments), end(increments), *this);
+		}
+		// path 0 of the batch is the makebm path of the fixture
+		CHECK_CLOSE(0., (sigs.to_tensor<TENSOR>(0) - sig).NormL1(), 10e-13);
+		// and the last path agrees with the sparse signature of its increments
+		std::vector<LIE> last(steps);
+		for (size_t i = 0; i < steps; ++i)
+			for (unsigned j = 0; j < ALPHABET_SIZE; ++j)
+				last[i] += LIE(j + 1, batch_increments[(i * ALPHABET_SIZE + j) * batch + batch - 1]);
+		TENSOR sig_last = ::signature(last.begin(), last.end(), *this);
+		CHECK_CLOSE(0., (sigs.to_tensor<TENSOR>(batch - 1) - sig_last).NormL1(), 10e-13);
+
+		// batched log, t2l and exp
+		batch_tensor<ALPHABET_SIZE, DEPTH> logs(sigs), scratch(batch);
+		log_inplace(logs, scratch);
+		CHECK_CLOSE(0., (logs.to_tensor<TENSOR>(batch - 1) - log(sig_last)).NormL1(), 10e-13);
+		std::vector<double> lie_coefficients;
+		batch_t2l(logs, *this, lie_coefficients);
+		LIE logsig_last;
+		for (size_t k = 0; k < LIE::basis.size(); ++k)
+			logsig_last += LIE(typename LIE::KEY(k + 1), S(lie_coefficients[k * batch + batch - 1]));
+		CHECK_CLOSE(0., (logsig_last - maps.t2l(log(sig_last))).NormL1(), 10e-13);
+		exp_inplace(logs, scratch);
+		CHECK_CLOSE(0., (logs.to_tensor<TENSOR>(batch - 1) - sig_last).NormL1(), 10e-13);
+	}
+
+	TEST_FIXTURE(SETUP42, bm42_counter_based_paths_are_reproducible)
+	{
+		TEST_DETAILS();
+		// Philox4x32-10 known answers (Random123)
+		uint32_t w[4];
+		philox4x32(w, 0, 0, 0, 0, 0);
+		CHECK(w[0] == 0x6627e8d5 && w[1] == 0xe169c58d && w[2] == 0xbc57ac4c && w[3] == 0x9b00dbd8);
+		philox4x32(w, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffffffffffff);
+		CHECK(w[0] == 0x408f276d && w[1] == 0x41c83b0e && w[2] == 0xa20bc7c6 && w[3] == 0x6d5451fd);
+
+		// the path is bit identical whatever the number of threads
+		const philox_seed seed = { 0x6d35f0e5b8f6c603 };
+		const size_t steps = 100000;
+		std::vector<double> path1, pathn;
+		const int threads = omp_get_max_threads();
+		omp_set_num_threads(1);
+		makebm(path1, steps, ALPHABET_SIZE, seed);
+		omp_set_num_threads(std::max(threads, 4));
+		std::cout << "counter based path of " << steps << " steps: ";
+		{
+			timer path_t;
+			makebm(pathn, steps, ALPHABET_SIZE, seed);
+		}
+		omp_set_num_threads(threads);
+		CHECK(path1 == pathn);
+
+		// and any range of increments is that slice of the whole
+		std::vector<double> all(steps * ALPHABET_SIZE), range(777 * ALPHABET_SIZE);
+		makebm_increments(all.data(), 0, steps, steps, ALPHABET_SIZE, seed);
+		makebm_increments(range.data(), 54321, 777, steps, ALPHABET_SIZE, seed);
+		CHECK(std::equal(range.begin(), range.end(), all.begin() + 54321 * ALPHABET_SIZE));
+		makebm_increments_serial(range.data(), 54321, 777, steps, ALPHABET_SIZE, seed);
+		CHECK(std::equal(range.begin(), range.end(), all.begin() + 54321 * ALPHABET_SIZE));
+		double sum = 0., sum2 = 0.;
+		for (const double x : all) {
+			sum += x;
+			sum2 += x * x;
+		}
+		// mean 0 and variance 1 / steps, to a few standard errors
+		CHECK_CLOSE(0., sum / double(all.size()), 5. / std::sqrt(double(steps) * double(all.size())));
+		CHECK_CLOSE(1., sum2 / double(steps * ALPHABET_SIZE) * double(steps), 0.02);
+
+		// the brownian path increments of the seed
+		brown_path_increments<DEPTH, ALPHABET_SIZE, 50> bm(seed);
+		CHECK_EQUAL(size_t(50), bm.increments.size());
+		std::vector<double> first(50 * ALPHABET_SIZE);
+		makebm_increments(first.data(), 0, 50, 50, ALPHABET_SIZE, seed);
+		LIE expected;
+		for (size_t j = 0; j < ALPHABET_SIZE; ++j)
+			expected += LIE(typename LIE::KEY(j + 1), S(first[49 * ALPHABET_SIZE + j]));
+		CHECK_CLOSE(0., (bm.increments[49] - expected).NormL1(), 0.);
+
+		// and the categorical path of the seed
+		categorical_path<DEPTH, ALPHABET_SIZE, DPReal> walk(seed, 1000);
+		size_t counts[ALPHABET_SIZE] = {};
+		for (size_t i = 0; i < walk.Steps(); ++i) {
+			const size_t letter = philox_letter(seed, i, ALPHABET_SIZE);
+			CHECK_CLOSE(0., (walk.begin()[i] - LIE(typename LIE::KEY(letter), S(1))).NormL1(), 0.);
+			++counts[letter - 1];
+		}
+		CHECK(counts[0] > 400 && counts[1] > 400);
+	}
+
+	TEST_FIXTURE(SETUP42, bm42_dyadic_signature_pyramid)
+	{
+		TEST_DETAILS();
+		const size_t steps = increments.size();
+		std::cout << "signature pyramid: ";
+		const dyadic_pyramid<TENSOR> sigs = [&] {
+			timer pyramid_t;
+			return ::o_signature_pyramid(begin(increments), end(increments), *this);
+		}();
+		// 50, 25, 13, 7, 4, 2, 1 blocks
+		CHECK_EQUAL(7u, sigs.levels());
+		CHECK_EQUAL(size_t(102), sigs.size());
+		CHECK_EQUAL(size_t(13), sigs.level_size(2));
+		CHECK_CLOSE(0., (sigs.root() - signature(begin(increments), end(increments))).NormL1(), 10e-13);
+		for (unsigned l = 0; l < sigs.levels(); ++l)
+			for (const size_t j : { size_t(0), sigs.level_size(l) - 1 }) {
+				const TENSOR block = signature(begin(increments) + sigs.block_begin(l, j), begin(increments) + sigs.block_end(l, j));
+				CHECK_CLOSE(0., (sigs(l, j) - block).NormL1(), 10e-13);
+			}
+		// block 12 of level 2 covers the last two increments and is shared with its one child
+		CHECK(sigs.single_child(2, 12) && sigs.at(sigs.index(2, 12)).shares(sigs.at(sigs.index(1, 24))));
+		CHECK_EQUAL(steps, sigs.block_end(2, 12));
+
+		// the logsignatures
+		const dyadic_pyramid<LIE> logsigs = ::o_logsignature_pyramid(begin(increments), end(increments), *this);
+		CHECK_CLOSE(0., (logsigs.root() - maps.t2l(log(sigs.root()))).NormL1(), 10e-13);
+		CHECK_CLOSE(0., (logsigs(3, 2) - maps.t2l(log(sigs(3, 2)))).NormL1(), 10e-13);
+		// the leaves are the increments themselves
+		CHECK(logsigs(0, 7) == increments[7]);
+
+		// to disk, one row per block
+		{
+			feature_matrix matrix("pyramid.f32", logsigs.size(), LIE::basis.size());
+			write_lie_pyramid(logsigs, matrix);
+			const auto k = *logsigs(3, 2).begin();
+			CHECK_CLOSE(double(k.second), double(matrix.row(logsigs.index(3, 2))[size_t(k.first) - 1]), 1.0e-6);
+		}
+		boost::filesystem::remove("pyramid.f32");
+		{
+			feature_matrix matrix("pyramid.f32", sigs.size(), TENSOR::basis.size());
+			write_pyramid<ALPHABET_SIZE, DEPTH>(sigs, matrix);
+			CHECK_EQUAL(1.f, matrix.row(sigs.index(4, 1))[0]);
+		}
+		boost::filesystem::remove("pyramid.f32");
+	}
+
+	TEST_FIXTURE(SETUP42, bm42_prefix_sharing_trie_signatures)
+	{
+		TEST_DETAILS();
+		// a trunk of 30 increments, four branches of 20 and the trunk itself
+		std::vector<std::vector<LIE>> paths;
+		for (int b = 0; b < 4; ++b) {
+			std::vector<LIE> path(increments.begin(), increments.begin() + 30);
+			for (size_t i = 30; i < 50; ++i)
+				path.push_back(increments[i] * S(b + 1));
+			paths.push_back(path);
+		}
+		paths.emplace_back(increments.begin(), increments.begin() + 30);
+		path_trie<LIE> trie;
+		for (const auto& path : paths)
+			trie.insert(path.begin(), path.end());
+		CHECK_EQUAL(size_t(1 + 30 + 4 * 20), trie.size());
+		CHECK_EQUAL(size_t(4 * 50 + 30), trie.total_increments());
+
+		trie_signatures<TENSOR, LIE> sigs;
+		std::cout << "trie signatures: ";
+		{
+			timer trie_t;
+			sigs = ::o_trie_signatures(trie, *this, true);
+		}
+		CHECK_EQUAL(paths.size(), sigs.paths.size());
+		for (size_t p = 0; p < paths.size(); ++p)
+			CHECK_CLOSE(0., (sigs.paths[p] - ::signature(paths[p].begin(), paths[p].end(), *this)).NormL1(), 10e-13);
+		// the logsignatures of internal nodes: the end of the trunk, and the node 10 steps into it
+		const size_t trunk = trie.path_ends().back();
+		CHECK_EQUAL(size_t(30), trie.depth(trunk));
+		CHECK_CLOSE(0., (sigs.nodes[trunk] - maps.t2l(log(sigs.paths.back()))).NormL1(), 10e-13);
+		size_t node = trunk;
+		while (trie.depth(node) > 10)
+			node = trie.parent(node);
+		const TENSOR prefix = ::signature(increments.begin(), increments.begin() + 10, *this);
+		CHECK_CLOSE(0., (sigs.nodes[node] - maps.t2l(log(prefix))).NormL1(), 10e-13);
+	}
+
+	TEST_FIXTURE(SETUP42, bm42_monte_carlo_expected_signature)
+	{
+		TEST_DETAILS();
+		const philox_seed seed = { 0x6d35f0e5b8f6c603 };
+		signature_moments<ALPHABET_SIZE, DEPTH> estimate;
+		std::cout << "expected signature of 20000 paths: ";
+		{
+			timer mc_t;
+			estimate = monte_carlo_expected_signature<ALPHABET_SIZE, DEPTH>(20000, 50, seed);
+		}
+		CHECK_EQUAL(size_t(20000), estimate.samples);
+		// the expected signature of brownian motion on [0, 1] is exp(1/2 sum_i e_i e_i)
+		TENSOR half;
+		for (unsigned i = 1; i <= ALPHABET_SIZE; ++i)
+			half += TENSOR(TENSOR::basis.keyofletter(i), S(1)) * TENSOR(TENSOR::basis.keyofletter(i), S(0.5));
+		const TENSOR exact = exp(half);
+		const TENSOR mean = estimate.mean_tensor<TENSOR>();
+		typedef tensor_layout<ALPHABET_SIZE, DEPTH> LAYOUT;
+		for (unsigned d = 0; d <= DEPTH; ++d)
+			for (size_t i = 0; i < LAYOUT::level_size(d); ++i) {
+				const size_t w = LAYOUT::offset(d) + i;
+				const double expected = double(exact[LAYOUT::key<TENSOR>(d, i)]);
+				CHECK_CLOSE(expected, estimate.mean[w], 5. * estimate.standard_error[w]);
+			}
+		CHECK_EQUAL(1., estimate.mean[0]);
+		CHECK_EQUAL(0., estimate.standard_error[0]);
+		CHECK_CLOSE(0., (mean - exact).NormL1(), 0.1);
+
+		// reproducible, and the mean alone agrees
+		const signature_moments<ALPHABET_SIZE, DEPTH> again = monte_carlo_expected_signature<ALPHABET_SIZE, DEPTH>(20000, 50, seed, false);
+		CHECK(again.standard_error.empty());
+		for (size_t w = 0; w < again.mean.size(); ++w)
+			CHECK_CLOSE(estimate.mean[w], again.mean[w], 1.0e-15);
+	}
+
+	TEST_FIXTURE(SETUP42, bm42_signature_kernels_and_gram_matrix)
+	{
+		TEST_DETAILS();
+		const size_t steps = increments.size();
+		// the fixture path and a counter based path
+		std::vector<double> path, x(steps * ALPHABET_SIZE), y(steps * ALPHABET_SIZE);
+		makebm(path, steps, ALPHABET_SIZE);
+		for (size_t i = 0; i < steps * ALPHABET_SIZE; ++i)
+			x[i] = path[i + ALPHABET_SIZE] - path[i];
+		const philox_seed seed = { 0x6d35f0e5b8f6c603 };
+		makebm_increments(y.data(), 0, steps, steps, ALPHABET_SIZE, seed);
+
+		// against the inner product of the signatures truncated at DEPTH
+		std::vector<LIE> ly(steps);
+		for (size_t i = 0; i < steps; ++i)
+			for (unsigned j = 0; j < ALPHABET_SIZE; ++j)
+				ly[i] += LIE(j + 1, y[i * ALPHABET_SIZE + j]);
+		const TENSOR sx = ::signature(begin(increments), end(increments), *this), sy = ::signature(ly.begin(), ly.end(), *this);
+		double expected = 0.;
+		for (const auto& k : sx)
+			expected += double(k.second) * double(sy[k.first]);
+		truncated_signature_kernel truncated(ALPHABET_SIZE, DEPTH);
+		CHECK_CLOSE(expected, truncated(x.data(), steps, y.data(), steps), 1.0e-12);
+		double level2 = 0.;
+		for (const auto& k : sx)
+			if (TENSOR::basis.degree(k.first) == 2)
+				level2 += double(k.second) * double(sy[k.first]);
+		CHECK_CLOSE(level2, truncated.levels()[2], 1.0e-12);
+		// and for paths of different lengths
+		const TENSOR sy_half = ::signature(ly.begin(), ly.begin() + steps / 2, *this);
+		expected = 0.;
+		for (const auto& k : sx)
+			expected += double(k.second) * double(sy_half[k.first]);
+		CHECK_CLOSE(expected, truncated(x.data(), steps, y.data(), steps / 2), 1.0e-12);
+		CHECK_CLOSE(expected, truncated(y.data(), steps / 2, x.data(), steps), 1.0e-12);
+
+		// the untruncated kernel agrees with a deep truncation
+		truncated_signature_kernel deep(ALPHABET_SIZE, 12);
+		pde_signature_kernel pde(ALPHABET_SIZE, 4);
+		CHECK_CLOSE(deep(x.data(), steps, y.data(), steps), pde(x.data(), steps, y.data(), steps), 1.0e-4);
+
+		// the gram matrix of 40 paths
+		const size_t N = 40;
+		std::vector<double> paths(N * steps * ALPHABET_SIZE), gram;
+		for (size_t p = 0; p < N; ++p)
+			makebm_increments(&paths[p * steps * ALPHABET_SIZE], 0, steps, steps, ALPHABET_SIZE, philox_seed{ seed.value + p });
+		std::cout << "gram matrix of " << N << " paths: ";
+		{
+			timer gram_t;
+			signature_gram(paths.data(), N, steps, ALPHABET_SIZE, truncated, gram, 8);
+		}
+		for (const size_t p : { size_t(0), size_t(7), size_t(39) })
+			for (const size_t q : { size_t(0), size_t(8), size_t(23) }) {
+				CHECK_EQUAL(gram[p * N + q], gram[q * N + p]);
+				CHECK_CLOSE(truncated(&paths[p * steps * ALPHABET_SIZE], steps, &paths[q * steps * ALPHABET_SIZE], steps), gram[p * N + q], 1.0e-12);
+			}
+		CHECK_THROW(signature_gram(paths.data(), N, steps, ALPHABET_SIZE, truncated, gram, 0), std::invalid_argument);
+	}
 }
\ No newline at end of file
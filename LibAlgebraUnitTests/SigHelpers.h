@@ -4,6 +4,16 @@
 #include <omp.h>
 #include "SHOW.h"
 #include "log2ceil.h"
+#include "cow_vector.h"
+#include "dense_tensor.h"
+#include "small_tensor.h"
+#include "signature_sketch.h"
+#include "group_like.h"
+#include "path_file.h"
+#include "dyadic_pyramid.h"
+#include "path_trie.h"
+#include <stdexcept>
+#include <algorithm>
 // these helper functions are used widely in the tests
 // however, the tests duplicate the code and need to be modified to use these standard versions
 // these standard versions have not been tested
@@ -22,6 +32,367 @@ typename FRAMEWORK::TENSOR signature(ITERATOR_T begin, ITERATOR_T end, const FRA
 	return signature;
 }
 
+/// computes a signature from an iterable sequence of lie elements
+/// accumulating in a dense_tensor updated in place, so peak memory is one dense tensor and one increment
+template<typename ITERATOR_T, typename FRAMEWORK>
+typename FRAMEWORK::TENSOR inplace_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1));
+	for (ITERATOR_T i = begin; i != end; i++)
+		signature *= exp(context.maps.l2t(*i));
+	return signature.template to_tensor<TENSOR>();
+}
+
+/// computes a random projection sketch of the signature of an iterable sequence of degree one lie elements
+/// by propagating the sketch through the Chen recursion; the signature itself is never formed.
+/// Throws std::invalid_argument on an increment of higher degree
+template<typename ITERATOR_T, typename FRAMEWORK>
+std::vector<double> sketch_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context
+	, const signature_sketch<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>& sketch)
+{
+	std::vector<double> state = sketch.identity();
+	double x[FRAMEWORK::ALPHABET_SIZE];
+	for (ITERATOR_T i = begin; i != end; i++) {
+		degree_one_increment<FRAMEWORK::ALPHABET_SIZE>(*i, x);
+		sketch.update(state, x);
+	}
+	return sketch.values(state);
+}
+
+/// the tensor expansion l2t(k) of the Hall element k of degree d as the WIDTH^d coefficients of degree d in
+/// the tensor_layout order: [a, b] expands to ab - ba, a concatenation of words being an outer product of levels
+template<unsigned WIDTH, typename LIE, typename SCALAR>
+std::vector<SCALAR> hall_expansion(typename LIE::KEY k)
+{
+	const auto& parents = LIE::basis.hall_set[k];
+	if (parents.first == 0) {
+		std::vector<SCALAR> ans(WIDTH, SCALAR(0));
+		ans[parents.second - 1] = SCALAR(1);
+		return ans;
+	}
+	const std::vector<SCALAR> a = hall_expansion<WIDTH, LIE, SCALAR>(parents.first);
+	const std::vector<SCALAR> b = hall_expansion<WIDTH, LIE, SCALAR>(parents.second);
+	std::vector<SCALAR> ans(a.size() * b.size(), SCALAR(0));
+	outer_product_add(ans.data(), a.data(), a.size(), b.data(), b.size());
+	for (size_t j = 0; j < b.size(); ++j)
+		for (size_t i = 0; i < a.size(); ++i)
+			ans[j * a.size() + i] -= b[j] * a[i];
+	return ans;
+}
+
+/// computes the group-like element exp(arg) from a lie element directly
+/// the dense tensor of arg is built level by level, degree d from the Hall elements of degree d alone,
+/// and only the products that reach degrees <= DEPTH are formed (see exp of a dense_tensor)
+template<typename FRAMEWORK>
+typename FRAMEWORK::TENSOR lie_exp(const typename FRAMEWORK::LIE& arg, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> x, scratch;
+	for (const auto& k : arg) {
+		S* level = x.level(LIE::basis.degree(k.first));
+		const std::vector<S> expansion = hall_expansion<FRAMEWORK::ALPHABET_SIZE, LIE, S>(k.first);
+		for (size_t i = 0; i < expansion.size(); ++i)
+			level[i] += k.second * expansion[i];
+	}
+	exp_inplace(x, scratch);
+	return x.template to_tensor<TENSOR>();
+}
+
+/// the product lhs * rhs keeping only the degrees <= max_degree
+/// pairs of words that cannot reach max_degree are never formed
+template<typename TENSOR>
+TENSOR truncated_product(const TENSOR& lhs, const TENSOR& rhs, unsigned max_degree)
+{
+	TENSOR ans;
+	for (const auto& a : lhs) {
+		const unsigned da = TENSOR::basis.degree(a.first);
+		if (da > max_degree)
+			continue;
+		for (const auto& b : rhs)
+			if (da + TENSOR::basis.degree(b.first) <= max_degree)
+				ans.add_scal_prod(a.first * b.first, a.second * b.second);
+	}
+	return ans;
+}
+
+/// the lowest degree >= 1 carried by arg, or max_degree + 1 if there is none below it
+template<typename TENSOR>
+unsigned min_degree(const TENSOR& arg, unsigned max_degree)
+{
+	unsigned ans = max_degree + 1;
+	for (const auto& a : arg) {
+		const unsigned d = TENSOR::basis.degree(a.first);
+		if (d > 0 && d < ans)
+			ans = d;
+	}
+	return ans;
+}
+
+/// exp(x) truncated at depth for a TENSOR x with no scalar part
+/// if the lowest degree of x is m then x^k starts in degree k m, so the Horner form
+/// exp(x) = 1 + x (1 + x/2 (1 + ... (1 + x/N))) stops at N = depth / m and the k-th bracket
+/// is only formed up to degree depth - (k - 1) m
+template<typename TENSOR>
+TENSOR graded_exp(const TENSOR& x, unsigned depth)
+{
+	typedef typename TENSOR::SCALAR S;
+	const unsigned m = min_degree(x, depth);
+	TENSOR h(S(1));
+	if (m > depth)
+		return h;
+	for (unsigned k = depth / m; k >= 1; --k)
+		h = TENSOR(S(1)) + truncated_product(x, h, depth - (k - 1) * m) * (S(1) / S(k));
+	return h;
+}
+
+/// log(g) truncated at depth for a TENSOR g with scalar part one
+/// with x = g - 1 of lowest degree m the Horner form log(1 + x) = x (1 - x (1/2 - ... x/N))
+/// stops at N = depth / m and the bracket multiplied by k factors of x is only formed up to degree depth - k m
+template<typename TENSOR>
+TENSOR graded_log(const TENSOR& g, unsigned depth)
+{
+	typedef typename TENSOR::SCALAR S;
+	const TENSOR x = g - TENSOR(S(1));
+	const unsigned m = min_degree(x, depth);
+	if (m > depth)
+		return TENSOR();
+	const unsigned N = depth / m;
+	TENSOR h(S(1) / S(N));
+	for (unsigned k = N - 1; k >= 1; --k)
+		h = TENSOR(S(1) / S(k)) - truncated_product(x, h, depth - k * m);
+	return truncated_product(x, h, depth);
+}
+
+/// computes maps.t2l(log(sig)) for a group-like sig without the full tensor series (see graded_log)
+template<typename FRAMEWORK>
+typename FRAMEWORK::LIE lie_log(const typename FRAMEWORK::TENSOR& sig, const FRAMEWORK& context)
+{
+	return context.maps.t2l(graded_log(sig, FRAMEWORK::DEPTH));
+}
+
+/// the Dynkin map t2l applied to a dense tensor: sum over words w of arg[w] / |w| times the right bracketing of w
+template<typename FRAMEWORK>
+typename FRAMEWORK::LIE dense_t2l(const dense_tensor<typename FRAMEWORK::S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>& arg, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	typedef tensor_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> LAYOUT;
+	LIE ans;
+	for (unsigned d = 1; d <= FRAMEWORK::DEPTH; ++d) {
+		const S* level = arg.level(d);
+		for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+			if (level[i] != S(0))
+				ans.add_scal_prod(context.maps.rbraketing(LAYOUT::template key<TENSOR>(d, i)), level[i] / S(d));
+	}
+	return ans;
+}
+
+/// computes a signature in the fast_tensor for the shape: fully unrolled small_tensor kernels
+/// for tiny shapes (e.g. WIDTH 2, DEPTH 6) and dense_tensor otherwise
+template<typename ITERATOR_T, typename FRAMEWORK>
+typename FRAMEWORK::TENSOR fast_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::S S;
+	typedef fast_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> FAST;
+	FAST signature(S(1)), increment, scratch;
+	for (ITERATOR_T i = begin; i != end; i++) {
+		increment.assign(context.maps.l2t(*i));
+		exp_inplace(increment, scratch);
+		signature *= increment;
+	}
+	return signature.template to_tensor<typename FRAMEWORK::TENSOR>();
+}
+
+/// computes the logsignature with a dense signature updated in place, a graded dense log
+/// reusing one scratch tensor, and the Dynkin projection read straight off the dense levels
+template<typename ITERATOR_T, typename FRAMEWORK>
+typename FRAMEWORK::LIE fused_logsignature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::S S;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	DENSE signature(S(1)), scratch;
+	for (ITERATOR_T i = begin; i != end; i++)
+		signature *= exp(context.maps.l2t(*i));
+	log_inplace(signature, scratch);
+	return dense_t2l(signature, context);
+}
+
+// raw path ingestion: a path of steps + 1 points, or steps increments, each of ALPHABET_SIZE doubles
+// starting stride doubles apart (e.g. the makebm layout with stride == ALPHABET_SIZE), is consumed
+// directly by Chen updates of a dense signature, so no LIE is built for any step
+
+/// updates a dense signature with the steps increments of a raw path; is_path selects points or increments
+template<typename FRAMEWORK>
+void raw_chen_updates(dense_tensor<typename FRAMEWORK::S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>& signature
+	, const double* data, size_t steps, size_t stride, bool is_path)
+{
+	const unsigned WIDTH = FRAMEWORK::ALPHABET_SIZE;
+	std::vector<typename FRAMEWORK::S> scratch;
+	double x[WIDTH];
+	for (size_t i = 0; i < steps; ++i) {
+		raw_increment<WIDTH>(data + i * stride, stride, is_path, x);
+		chen_update<WIDTH, FRAMEWORK::DEPTH>(signature, x, scratch);
+	}
+}
+
+/// computes the signature of a path of steps + 1 points path + i * stride
+template<typename FRAMEWORK>
+typename FRAMEWORK::TENSOR raw_signature(const double* path, size_t steps, size_t stride, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1));
+	raw_chen_updates<FRAMEWORK>(signature, path, steps, stride, true);
+	return signature.template to_tensor<typename FRAMEWORK::TENSOR>();
+}
+
+/// computes the signature of a path given by steps increments increments + i * stride
+template<typename FRAMEWORK>
+typename FRAMEWORK::TENSOR raw_increments_signature(const double* increments, size_t steps, size_t stride, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1));
+	raw_chen_updates<FRAMEWORK>(signature, increments, steps, stride, false);
+	return signature.template to_tensor<typename FRAMEWORK::TENSOR>();
+}
+
+/// computes the logsignature of a path of steps + 1 points path + i * stride
+template<typename FRAMEWORK>
+typename FRAMEWORK::LIE raw_logsignature(const double* path, size_t steps, size_t stride, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1)), scratch;
+	raw_chen_updates<FRAMEWORK>(signature, path, steps, stride, true);
+	log_inplace(signature, scratch);
+	return dense_t2l(signature, context);
+}
+
+/// computes the logsignature of a path given by steps increments increments + i * stride
+template<typename FRAMEWORK>
+typename FRAMEWORK::LIE raw_increments_logsignature(const double* increments, size_t steps, size_t stride, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1)), scratch;
+	raw_chen_updates<FRAMEWORK>(signature, increments, steps, stride, false);
+	log_inplace(signature, scratch);
+	return dense_t2l(signature, context);
+}
+
+/// updates a dense signature with a path file read through windows of at most window_steps increments;
+/// consecutive windows share one point, so no increment is lost at a window boundary
+template<typename FRAMEWORK>
+void path_file_chen_updates(dense_tensor<typename FRAMEWORK::S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>& signature
+	, path_file& file, size_t window_steps)
+{
+	if (file.width() != FRAMEWORK::ALPHABET_SIZE)
+		throw std::runtime_error("path_file_chen_updates: the path width is not ALPHABET_SIZE");
+	for (size_t first = 0; first < file.steps(); first += window_steps) {
+		const size_t steps = std::min(window_steps, file.steps() - first);
+		raw_chen_updates<FRAMEWORK>(signature, file.window(first, steps + 1), steps, file.width(), true);
+	}
+}
+
+/// computes the signature of the path in a path file without loading it into memory
+template<typename FRAMEWORK>
+typename FRAMEWORK::TENSOR path_file_signature(path_file& file, const FRAMEWORK& context, size_t window_steps = size_t(1) << 16)
+{
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1));
+	path_file_chen_updates<FRAMEWORK>(signature, file, window_steps);
+	return signature.template to_tensor<typename FRAMEWORK::TENSOR>();
+}
+
+/// computes the logsignature of the path in a path file without loading it into memory
+template<typename FRAMEWORK>
+typename FRAMEWORK::LIE path_file_logsignature(path_file& file, const FRAMEWORK& context, size_t window_steps = size_t(1) << 16)
+{
+	typedef typename FRAMEWORK::S S;
+	dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(S(1)), scratch;
+	path_file_chen_updates<FRAMEWORK>(signature, file, window_steps);
+	log_inplace(signature, scratch);
+	return dense_t2l(signature, context);
+}
+
+// path compression: exp(a) exp(b) = exp(a + b) whenever [a, b] = 0, as for consecutive increments that
+// repeat a letter, are collinear or vanish, so such runs can be merged before any Chen product
+
+/// the merged increments of compress_increments and the number of increments they replace
+template <typename LIE>
+struct compressed_increments
+{
+	std::vector<LIE> increments;
+	size_t original = 0;
+
+	const LIE* begin() const { return increments.data(); }
+	const LIE* end() const { return increments.data() + increments.size(); }
+
+	/// input increments per merged increment
+	double ratio() const { return increments.empty() ? 1. : double(original) / double(increments.size()); }
+};
+
+/// merges each run of consecutive increments that commute with the running sum of the run, testing
+/// [sum, x] = 0 with the lie bracket: exactly for tolerance 0 (e.g. Rational), and for floating types
+/// to within |[sum, x]| <= tolerance |sum| |x| in the L1 norm. The signature is unchanged when exact.
+template<typename ITERATOR_T, typename FRAMEWORK>
+compressed_increments<typename FRAMEWORK::LIE> compress_increments(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context
+	, double tolerance = 0.)
+{
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	compressed_increments<LIE> ans;
+	const S bound(tolerance);
+	for (ITERATOR_T i = begin; i != end; ++i, ++ans.original) {
+		if (!ans.increments.empty()) {
+			LIE& run = ans.increments.back();
+			const S norms = run.NormL1() * i->NormL1();
+			const S bracket = (run * *i).NormL1();
+			if (bracket <= bound * norms) {
+				run += *i;
+				continue;
+			}
+		}
+		ans.increments.push_back(*i);
+	}
+	return ans;
+}
+
+/// computes a signature after merging the commuting runs of the increments (see compress_increments)
+template<typename ITERATOR_T, typename FRAMEWORK>
+typename FRAMEWORK::TENSOR compressed_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context
+	, double tolerance = 0.)
+{
+	const compressed_increments<typename FRAMEWORK::LIE> merged = compress_increments(begin, end, context, tolerance);
+	return signature(merged.begin(), merged.end(), context);
+}
+
+/// computes a signature typed as group-like, so that inverse() uses the antipode; the factors exp(l2t(x))
+/// are group-like by construction and are not checked
+template<typename ITERATOR_T, typename FRAMEWORK>
+group_like<typename FRAMEWORK::TENSOR> group_like_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	group_like<typename FRAMEWORK::TENSOR> signature;
+	for (ITERATOR_T i = begin; i != end; i++)
+		signature *= group_like<typename FRAMEWORK::TENSOR>::exponential(context.maps.l2t(*i));
+	return signature;
+}
+
+/// the signatures over [t_(k-1), t_k] between consecutive observation times from the signatures over [0, t_k]
+/// (t_(-1) = 0), each by signature_increment and so by the antipode rather than the power series inverse
+template<typename TENSOR>
+std::vector<group_like<TENSOR>> o_signature_increments(const std::vector<group_like<TENSOR>>& prefixes)
+{
+	std::vector<group_like<TENSOR>> ans(prefixes.size());
+	const ptrdiff_t N = ptrdiff_t(prefixes.size());
+#pragma omp parallel for
+	for (ptrdiff_t k = 0; k < N; ++k)
+		ans[size_t(k)] = (k == 0) ? prefixes[0] : signature_increment(prefixes[size_t(k) - 1], prefixes[size_t(k)]);
+	return ans;
+}
+
 /// computes the logsignature from the signature
 template<class ITERATOR_T, typename FRAMEWORK>
 typename FRAMEWORK::LIE logsignature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
@@ -38,24 +409,37 @@ typename FRAMEWORK::LIE o_logsignature(ITERATOR_T begin, ITERATOR_T end, const F
 	return context.maps.t2l(context.log(sig));
 }
 
-/// computes a signature from an iterable sequence of lie elements using OMP
+/// t2l(log(sig)) by a dense log and a dynkin_table, with scratch from the caller; unlike maps.t2l it
+/// can be called from several threads sharing one table
+template<typename FRAMEWORK>
+typename FRAMEWORK::LIE table_logsignature(const typename FRAMEWORK::TENSOR& sig
+	, const std::vector<std::vector<std::pair<size_t, double>>>& table
+	, dense_tensor<typename FRAMEWORK::S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>& logarithm
+	, dense_tensor<typename FRAMEWORK::S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>& horner
+	, std::vector<double>& lie)
+{
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	logarithm.assign(sig);
+	log_inplace(logarithm, horner);
+	lie.resize(LIE::basis.size());
+	dynkin_project(table, logarithm, lie);
+	LIE ans;
+	for (size_t k = 0; k < lie.size(); ++k)
+		if (lie[k] != 0.)
+			ans += LIE(typename LIE::KEY(k + 1), S(lie[k]));
+	return ans;
+}
+
+/// the signatures of the CTreeBufferHelper tree over the increments padded with the identity to a power of two:
+/// the leaves first, then each level of products, the root last
 template<typename ITERATOR_T, typename FRAMEWORK>
-typename FRAMEWORK::TENSOR o_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+std::vector<cow_vector<typename FRAMEWORK::TENSOR>> o_signature_tree(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
 {
 	typedef typename FRAMEWORK::TENSOR TENSOR;
 	typedef typename FRAMEWORK::LIE LIE;
 	typedef typename FRAMEWORK::S S;
 	auto& maps = context.maps;
-	auto& cbh = context.cbh;
-	//#undef  _OPENMP
-//#ifndef _OPENMP
-#if 0
-		 //simple non-parallel form
-	TENSOR signature(S(1));
-	for (ITERATOR_T i = begin; i != end; i++)
-		signature *= exp(maps.l2t(*i));
-	return signature;
-#else
 	ptrdiff_t leaves = log2ceil(size_t(end - begin));
 	const LIE* in = &(*begin);
 	CTreeBufferHelper t(1, leaves);
@@ -65,21 +449,177 @@ typename FRAMEWORK::TENSOR o_signature(ITERATOR_T begin, ITERATOR_T end, const F
 	// only requires one element per thread; 
 	// the approach here retains all intermediate values 
 	// and is wasteful unless required
-	std::vector<TENSOR> sigs(e, TENSOR(S(1)));
+	// the padding shares a single copy-on-write identity so costs O(1) per leaf
+	const cow_vector<TENSOR> identity(TENSOR(S(1)));
+	std::vector<cow_vector<TENSOR>> sigs(e, identity);
 
 #pragma omp parallel for
 	for (ptrdiff_t i = 0; i < end - begin; i++)
-		sigs[i] = exp(maps.l2t(in[i]));
+		sigs[i] = cow_vector<TENSOR>(exp(maps.l2t(in[i])));
 
 	for (ptrdiff_t j = t.parent(0); j < e; j = t.parent(j))
 	{
 		ptrdiff_t jj = t.parent(j);
 #pragma omp parallel for
 		for (ptrdiff_t i = j; i < jj; i++) {
-			// use move semantics and avoid a copy?
-			sigs[i] = sigs[t.left(i)] * sigs[t.right(i)];		
+			// products with the padding are O(1) shared copies
+			if (sigs[t.right(i)].shares(identity))
+				sigs[i] = sigs[t.left(i)];
+			else if (sigs[t.left(i)].shares(identity))
+				sigs[i] = sigs[t.right(i)];
+			else
+				sigs[i] = sigs[t.left(i)] * sigs[t.right(i)];
 		}
 	}
-	return *(sigs.crbegin());
+	return sigs;
+}
+
+/// computes a signature from an iterable sequence of lie elements using OMP
+template<typename ITERATOR_T, typename FRAMEWORK>
+typename FRAMEWORK::TENSOR o_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	//#undef  _OPENMP
+//#ifndef _OPENMP
+#if 0
+		 //simple non-parallel form
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::S S;
+	auto& maps = context.maps;
+	TENSOR signature(S(1));
+	for (ITERATOR_T i = begin; i != end; i++)
+		signature *= exp(maps.l2t(*i));
+	return signature;
+#else
+	return o_signature_tree(begin, end, context).back().release();
 #endif // _OPENMP
 };
+
+/// the signatures of all the dyadic blocks of the increments, at every scale, from the tree of o_signature;
+/// the blocks are the tree nodes that meet the path, shared rather than copied
+template<typename ITERATOR_T, typename FRAMEWORK>
+dyadic_pyramid<typename FRAMEWORK::TENSOR> o_signature_pyramid(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	const std::vector<cow_vector<TENSOR>> sigs = o_signature_tree(begin, end, context);
+	dyadic_pyramid<TENSOR> ans(size_t(end - begin));
+	// level l of the tree starts at leaves + leaves / 2 + .. + leaves / 2^(l - 1)
+	size_t tree_offset = 0, tree_level_size = log2ceil(size_t(end - begin));
+	for (unsigned l = 0; l < ans.levels(); ++l) {
+		for (size_t j = 0; j < ans.level_size(l); ++j)
+			ans.at(ans.index(l, j)) = sigs[tree_offset + j];
+		tree_offset += tree_level_size;
+		tree_level_size /= 2;
+	}
+	return ans;
+}
+
+/// the logsignatures of all the dyadic blocks of the increments, at every scale (see o_signature_pyramid);
+/// the leaves are the increments themselves, and the logs of the blocks above are dense and projected by a
+/// dynkin_table, so that the blocks are shared among the threads
+template<typename ITERATOR_T, typename FRAMEWORK>
+dyadic_pyramid<typename FRAMEWORK::LIE> o_logsignature_pyramid(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	const dyadic_pyramid<TENSOR> sigs = o_signature_pyramid(begin, end, context);
+	const std::vector<std::vector<std::pair<size_t, double>>> table = dynkin_table(context);
+	dyadic_pyramid<LIE> ans(sigs.steps());
+	// log(exp(x)) = x for a leaf, the blocks with two children are computed and those with one share their child's log
+	for (size_t j = 0; j < ans.level_size(0); ++j)
+		ans.at(ans.index(0, j)) = cow_vector<LIE>(LIE(*(begin + j)));
+	std::vector<size_t> computed;
+	for (unsigned l = 1; l < sigs.levels(); ++l)
+		for (size_t j = 0; j < sigs.level_size(l); ++j)
+			if (!sigs.single_child(l, j))
+				computed.push_back(sigs.index(l, j));
+	const ptrdiff_t N = ptrdiff_t(computed.size());
+#pragma omp parallel
+	{
+		DENSE logarithm, horner;
+		std::vector<double> lie(LIE::basis.size());
+#pragma omp for
+		for (ptrdiff_t i = 0; i < N; ++i)
+			ans.at(computed[size_t(i)]).mutate() = table_logsignature<FRAMEWORK>(*sigs.at(computed[size_t(i)]), table, logarithm, horner, lie);
+	}
+	for (unsigned l = 1; l < ans.levels(); ++l)
+		for (size_t j = 0; j < ans.level_size(l); ++j)
+			if (ans.single_child(l, j))
+				ans.at(ans.index(l, j)) = ans.at(ans.index(l - 1, 2 * j));
+	return ans;
+}
+
+/// the signatures of the paths of a path_trie, in the order inserted, and optionally the logsignatures of
+/// all its nodes (node 0 being the empty path)
+template<typename TENSOR, typename LIE>
+struct trie_signatures
+{
+	std::vector<TENSOR> paths;
+	std::vector<LIE> nodes;
+};
+
+/// computes the signatures of the paths of a trie by Chen's identity along its edges, sig(node) = sig(parent)
+/// exp(increment), so the work is one exponential and one product per distinct node however many paths
+/// share it. The nodes of each depth are done in parallel, or in place if a depth has only one node as along
+/// a shared trunk, and the signatures of a depth are released once the next is done, unless a path ends
+/// there. The log scratch is allocated once per thread, and only if node logsignatures are asked for.
+template<typename FRAMEWORK>
+trie_signatures<typename FRAMEWORK::TENSOR, typename FRAMEWORK::LIE> o_trie_signatures(const path_trie<typename FRAMEWORK::LIE>& trie, const FRAMEWORK& context
+	, bool node_logsignatures = false)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef typename FRAMEWORK::S S;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	auto& maps = context.maps;
+
+	// the nodes by depth, and those at which a path ends
+	std::vector<std::vector<size_t>> levels;
+	for (size_t n = 0; n < trie.size(); ++n) {
+		if (trie.depth(n) >= levels.size())
+			levels.resize(trie.depth(n) + 1);
+		levels[trie.depth(n)].push_back(n);
+	}
+	std::vector<bool> ends(trie.size(), false);
+	for (const size_t n : trie.path_ends())
+		ends[n] = true;
+
+	trie_signatures<TENSOR, LIE> ans;
+	std::vector<std::vector<std::pair<size_t, double>>> table;
+	if (node_logsignatures) {
+		table = dynkin_table(context);
+		ans.nodes.resize(trie.size());
+	}
+	const cow_vector<TENSOR> empty;
+	std::vector<cow_vector<TENSOR>> sigs(trie.size(), empty);
+	sigs[path_trie<LIE>::root] = cow_vector<TENSOR>(TENSOR(S(1)));
+
+	// the scratch of each thread for the logs
+	const size_t threads = node_logsignatures ? size_t(omp_get_max_threads()) : 0;
+	std::vector<DENSE> logarithms(threads), horners(threads);
+	std::vector<std::vector<double>> lies(threads);
+	auto node = [&](size_t n, size_t t) {
+		sigs[n] = cow_vector<TENSOR>(TENSOR(*sigs[trie.parent(n)] * exp(maps.l2t(trie.increment(n)))));
+		if (node_logsignatures)
+			ans.nodes[n] = table_logsignature<FRAMEWORK>(*sigs[n], table, logarithms[t], horners[t], lies[t]);
+	};
+
+	for (size_t d = 1; d < levels.size(); ++d) {
+		const std::vector<size_t>& level = levels[d];
+		const ptrdiff_t N = ptrdiff_t(level.size());
+		if (N == 1)
+			node(level[0], 0);
+		else {
+#pragma omp parallel for
+			for (ptrdiff_t i = 0; i < N; ++i)
+				node(level[size_t(i)], size_t(omp_get_thread_num()));
+		}
+		for (const size_t n : levels[d - 1])
+			if (!ends[n])
+				sigs[n] = empty;
+	}
+	for (const size_t n : trie.path_ends())
+		ans.paths.push_back(*sigs[n]);
+	return ans;
+}
@@ -0,0 +1,79 @@
+// the libalgebra framework
+#include "alg_framework.h"
+
+// the unit test framework
+#include <UnitTest++/UnitTest++.h>
+#include "time_and_details.h"
+
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include "brown_path_increments.h"
+#include "tt_signature.h"
+
+// validates the low rank (tensor-train) signatures against the full signature
+SUITE(TENSOR_TRAIN_SIGNATURES)
+{
+	// DEPTH, ALPHABET SIZE, STEPS
+	typedef brown_path_increments<5, 4, 30> SETUP54;
+
+	// the letters of a tensor word
+	template <typename TENSOR>
+	std::vector<alg::LET> letters(typename TENSOR::KEY k)
+	{
+		std::vector<alg::LET> ans;
+		for (; TENSOR::basis.degree(k) > 0; k = TENSOR::basis.rparent(k))
+			ans.push_back(TENSOR::basis.getfirstletter(k));
+		return ans;
+	}
+
+	TEST_FIXTURE(SETUP54, tt_signature_agrees_with_signature)
+	{
+		TEST_DETAILS();
+		auto begin = increments.cbegin();
+		auto end = increments.cend();
+		TENSOR sig = signature(begin, end);
+		auto tt = tt_signature_of(begin, end, *this);
+
+		// every coordinate
+		double norm2 = 0.;
+		for (auto k : sig) {
+			std::vector<alg::LET> word = letters<TENSOR>(k.first);
+			CHECK_CLOSE(k.second, tt.coordinate(word.begin(), word.end()), 1.0e-10);
+			norm2 += k.second * k.second;
+		}
+		// the inner product
+		CHECK_CLOSE(norm2, dot(tt, tt), 1.0e-9);
+		std::cout << "tensor-train storage " << tt.storage() << " against " << TENSOR::basis.size() << " coordinates\n";
+	}
+
+	TEST_FIXTURE(SETUP54, tt_signature_rank_truncation)
+	{
+		TEST_DETAILS();
+		auto begin = increments.cbegin();
+		auto end = increments.cend();
+		auto exact = tt_signature_of(begin, end, *this);
+		auto approx = tt_signature_of(begin, end, *this, 1.0e-12, 4);
+
+		// memory follows the rank
+		CHECK(approx.storage() < exact.storage());
+		for (unsigned n = 1; n <= DEPTH; ++n)
+			CHECK(approx.level(n).rank() <= 4);
+
+		// the approximation error is small relative to the signature
+		double error = std::sqrt(std::fabs(dot(exact, exact) - 2. * dot(exact, approx) + dot(approx, approx)));
+		std::cout << "rank 4 storage " << approx.storage() << " against " << exact.storage()
+			<< " relative error " << error / std::sqrt(dot(exact, exact))
+			<< " discarded " << approx.discarded() << "\n";
+		CHECK(error < 0.1 * std::sqrt(dot(exact, exact)));
+	}
+
+	TEST_FIXTURE(SETUP54, tt_signature_rejects_higher_degree_increments)
+	{
+		TEST_DETAILS();
+		// a bracket [1, 2] has no degree one coordinates to carry
+		std::vector<LIE> path(increments.cbegin(), increments.cend());
+		path.push_back(LIE(1, S(1)) * LIE(2, S(1)));
+		CHECK_THROW(tt_signature_of(path.cbegin(), path.cend(), *this), std::invalid_argument);
+	}
+}
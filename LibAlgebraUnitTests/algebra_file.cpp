@@ -0,0 +1,171 @@
+#include "algebra_file.h"
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	const char algebra_file_magic[8] = { 'L', 'A', 'A', 'L', 'G', 0, 0, 0 };
+	// the data starts on a 64 byte boundary
+	const uint64_t algebra_file_data_offset = 64;
+
+	// little endian encoding and decoding of the fixed width fields
+	void put(char* out, uint64_t v, unsigned bytes)
+	{
+		for (unsigned i = 0; i < bytes; ++i)
+			out[i] = char((v >> (8 * i)) & 0xff);
+	}
+
+	uint64_t get(const char* in, unsigned bytes)
+	{
+		uint64_t v = 0;
+		for (unsigned i = 0; i < bytes; ++i)
+			v |= uint64_t((unsigned char)in[i]) << (8 * i);
+		return v;
+	}
+
+	uint64_t bits(double d)
+	{
+		uint64_t v;
+		std::memcpy(&v, &d, sizeof(v));
+		return v;
+	}
+
+	double from_bits(uint64_t v)
+	{
+		double d;
+		std::memcpy(&d, &v, sizeof(d));
+		return d;
+	}
+}
+
+bool algebra_file::native_little_endian()
+{
+	const uint16_t one = 1;
+	return *(const char*)&one == 1;
+}
+
+void algebra_file::write(boost::filesystem::path filename, uint32_t kind, uint32_t encoding, uint32_t width, uint32_t depth
+	, uint64_t dimension, std::vector<algebra_file_entry>& entries)
+{
+	std::vector<char> bytes(algebra_file_data_offset, 0);
+	if (encoding == DENSE) {
+		bytes.resize(size_t(algebra_file_data_offset + dimension * 8), 0);
+		for (const auto& e : entries)
+			put(&bytes[size_t(algebra_file_data_offset + e.index * 8)], bits(e.value), 8);
+	}
+	else {
+		std::sort(entries.begin(), entries.end(), [](const algebra_file_entry& lhs, const algebra_file_entry& rhs) {return lhs.index < rhs.index; });
+		bytes.resize(size_t(algebra_file_data_offset + entries.size() * 16), 0);
+		char* out = &bytes[size_t(algebra_file_data_offset)];
+		for (const auto& e : entries) {
+			put(out, e.index, 8);
+			put(out + 8, bits(e.value), 8);
+			out += 16;
+		}
+	}
+
+	// the header
+	char* out = &bytes[0];
+	std::memcpy(out, algebra_file_magic, 8);
+	put(out + 8, VERSION, 4);
+	put(out + 12, kind, 4);
+	put(out + 16, encoding, 4);
+	put(out + 20, FLOAT64, 4);
+	put(out + 24, width, 4);
+	put(out + 28, depth, 4);
+	put(out + 32, dimension, 8);
+	put(out + 40, (encoding == DENSE) ? dimension : entries.size(), 8);
+	put(out + 48, algebra_file_data_offset, 8);
+
+	boost::filesystem::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	file.write(bytes.data(), bytes.size());
+	if (!file)
+		throw std::runtime_error("algebra_file::write: cannot write " + filename.string());
+}
+
+algebra_view::algebra_view(boost::filesystem::path filename) : file(filename.string())
+{
+	if (!file.is_open() || file.size() < algebra_file_data_offset || std::memcmp(file.data(), algebra_file_magic, 8) != 0)
+		throw std::runtime_error("algebra_view: not an algebra file " + filename.string());
+	const char* in = file.data();
+	std::memcpy(h.magic, in, 8);
+	h.version = uint32_t(get(in + 8, 4));
+	h.kind = uint32_t(get(in + 12, 4));
+	h.encoding = uint32_t(get(in + 16, 4));
+	h.dtype = uint32_t(get(in + 20, 4));
+	h.width = uint32_t(get(in + 24, 4));
+	h.depth = uint32_t(get(in + 28, 4));
+	h.dimension = get(in + 32, 8);
+	h.count = get(in + 40, 8);
+	h.data_offset = get(in + 48, 8);
+	if (h.version != algebra_file::VERSION || h.dtype != algebra_file::FLOAT64 || h.data_offset % 8 != 0
+		|| (h.kind != algebra_file::TENSOR_KIND && h.kind != algebra_file::LIE_KIND)
+		|| (h.encoding != algebra_file::DENSE && h.encoding != algebra_file::SPARSE))
+		throw std::runtime_error("algebra_view: unsupported algebra file " + filename.string());
+	// sizes compared by division, so that a corrupt count cannot overflow
+	const uint64_t entry_size = (h.encoding == algebra_file::DENSE) ? 8 : 16;
+	if (h.data_offset < algebra_file_data_offset || h.data_offset > file.size()
+		|| h.count > (file.size() - h.data_offset) / entry_size)
+		throw std::runtime_error("algebra_view: truncated algebra file " + filename.string());
+	data = in + h.data_offset;
+	if (h.encoding == algebra_file::DENSE) {
+		if (h.count != h.dimension)
+			throw std::runtime_error("algebra_view: dense data does not match the dimension in " + filename.string());
+	}
+	else
+		for (size_t i = 0; i < count(); ++i)
+			if (index(i) >= h.dimension || (i > 0 && index(i) <= index(i - 1)))
+				throw std::runtime_error("algebra_view: sparse index out of range or order in " + filename.string());
+}
+
+const algebra_file_header& algebra_view::header() const
+{
+	return h;
+}
+
+size_t algebra_view::count() const
+{
+	return size_t(h.count);
+}
+
+const double* algebra_view::dense() const
+{
+	return (h.encoding == algebra_file::DENSE && algebra_file::native_little_endian()) ? (const double*)data : nullptr;
+}
+
+const algebra_file_entry* algebra_view::sparse() const
+{
+	return (h.encoding == algebra_file::SPARSE && algebra_file::native_little_endian()) ? (const algebra_file_entry*)data : nullptr;
+}
+
+uint64_t algebra_view::index(size_t i) const
+{
+	return (h.encoding == algebra_file::DENSE) ? uint64_t(i) : get(data + 16 * i, 8);
+}
+
+double algebra_view::value(size_t i) const
+{
+	return from_bits(get((h.encoding == algebra_file::DENSE) ? data + 8 * i : data + 16 * i + 8, 8));
+}
+
+bool algebra_view::find(uint64_t index, double& v) const
+{
+	if (h.encoding == algebra_file::DENSE) {
+		if (index >= h.count)
+			return false;
+		v = value(size_t(index));
+		return true;
+	}
+	size_t lo = 0, hi = count();
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (this->index(mid) < index)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == count() || this->index(lo) != index)
+		return false;
+	v = value(lo);
+	return true;
+}
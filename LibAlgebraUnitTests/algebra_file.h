@@ -0,0 +1,145 @@
+#pragma once
+// boost dependencies
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem/path.hpp>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <stddef.h> //size_t
+#include "tensor_layout.h"
+
+// a versioned, self describing binary format for TENSOR and LIE elements
+//
+// the 64 byte header and all data are little endian whatever the host, so files move between machines;
+// coordinates are IEEE doubles indexed by basis position: tensor_layout order for a TENSOR and
+// key - 1 for a LIE (the Hall basis is numbered from 1 by degree).
+//   dense encoding:  count doubles, one per basis element
+//   sparse encoding: count (uint64 index, double value) entries in increasing index order
+// On a little endian host an algebra_view maps the file read only and exposes the data in place.
+// The view checks the header and data against each other when opened, so every stored index is below
+// dimension; the loaders check dimension against the basis of the algebra they build.
+
+struct algebra_file_header
+{
+	char magic[8];			// "LAALG\0\0\0"
+	uint32_t version;		// algebra_file::VERSION
+	uint32_t kind;			// algebra_file::TENSOR_KIND or algebra_file::LIE_KIND
+	uint32_t encoding;		// algebra_file::DENSE or algebra_file::SPARSE
+	uint32_t dtype;			// algebra_file::FLOAT64, the only scalar stored
+	uint32_t width;
+	uint32_t depth;
+	uint64_t dimension;		// the dimension of the truncated basis
+	uint64_t count;			// doubles (dense) or entries (sparse) in the data
+	uint64_t data_offset;	// bytes from the start of the file to the data
+};
+
+/// an entry of the sparse encoding
+struct algebra_file_entry
+{
+	uint64_t index;
+	double value;
+};
+
+namespace algebra_file {
+	const uint32_t VERSION = 1;
+	enum : uint32_t { TENSOR_KIND = 1, LIE_KIND = 2 };
+	enum : uint32_t { DENSE = 0, SPARSE = 1 };
+	enum : uint32_t { FLOAT64 = 1 };
+
+	/// true if the host stores integers and doubles little endian
+	bool native_little_endian();
+
+	/// writes the (basis index, value) entries, in any order, as a header and little endian data in the given encoding
+	void write(boost::filesystem::path filename, uint32_t kind, uint32_t encoding, uint32_t width, uint32_t depth
+		, uint64_t dimension, std::vector<algebra_file_entry>& entries);
+}
+
+/// algebra_view - a read only memory mapped algebra file
+///
+/// dense() and sparse() point into the mapping on little endian hosts (zero copy) and are null
+/// elsewhere; index(i) and value(i) decode either encoding on any host.
+struct algebra_view
+{
+public:
+	// constructor
+	// throws std::runtime_error if the file is not a supported algebra file, is truncated, or stores
+	// an index at or above its dimension or (sparse) out of increasing order
+	explicit algebra_view(boost::filesystem::path filename);
+
+	// accessors
+	const algebra_file_header& header() const;
+	size_t count() const;
+	const double* dense() const;
+	const algebra_file_entry* sparse() const;
+
+	/// the basis index and value of the i-th stored coordinate in either encoding
+	uint64_t index(size_t i) const;
+	double value(size_t i) const;
+
+	/// the value stored at a basis index, by position (dense) or binary search (sparse); false if absent
+	bool find(uint64_t index, double& value) const;
+
+private:
+	algebra_file_header h;
+	boost::iostreams::mapped_file_source file;
+	const char* data;
+};
+
+/// saves a TENSOR of width WIDTH truncated at DEPTH in the given encoding
+template <unsigned WIDTH, unsigned DEPTH, typename TENSOR>
+void save_tensor(const TENSOR& arg, boost::filesystem::path filename, uint32_t encoding = algebra_file::SPARSE)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	std::vector<algebra_file_entry> entries;
+	entries.reserve(arg.size());
+	for (const auto& k : arg)
+		entries.push_back(algebra_file_entry{ uint64_t(LAYOUT::template index<TENSOR>(k.first)), double(k.second) });
+	algebra_file::write(filename, algebra_file::TENSOR_KIND, encoding, WIDTH, DEPTH, LAYOUT::size(), entries);
+}
+
+/// saves a LIE of width WIDTH truncated at DEPTH in the given encoding
+template <unsigned WIDTH, unsigned DEPTH, typename LIE>
+void save_lie(const LIE& arg, boost::filesystem::path filename, uint32_t encoding = algebra_file::SPARSE)
+{
+	std::vector<algebra_file_entry> entries;
+	entries.reserve(arg.size());
+	for (const auto& k : arg)
+		entries.push_back(algebra_file_entry{ uint64_t(k.first) - 1, double(k.second) });
+	algebra_file::write(filename, algebra_file::LIE_KIND, encoding, WIDTH, DEPTH, hall_layout<WIDTH, DEPTH>::size(), entries);
+}
+
+/// the TENSOR held in a view, which must be a tensor of the same width and depth
+template <unsigned WIDTH, unsigned DEPTH, typename TENSOR>
+TENSOR load_tensor(const algebra_view& view)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	const algebra_file_header& h = view.header();
+	if (h.kind != algebra_file::TENSOR_KIND || h.width != WIDTH || h.depth != DEPTH || h.dimension != LAYOUT::size())
+		throw std::runtime_error("load_tensor: the file holds a different algebra");
+	TENSOR ans;
+	for (size_t i = 0; i < view.count(); ++i) {
+		const double v = view.value(i);
+		if (v != 0.) {
+			const size_t index = size_t(view.index(i));
+			const unsigned d = LAYOUT::degree(index);
+			ans[LAYOUT::template key<TENSOR>(d, index - LAYOUT::offset(d))] = typename TENSOR::SCALAR(v);
+		}
+	}
+	return ans;
+}
+
+/// the LIE held in a view, which must be a lie element of the same width and depth
+template <unsigned WIDTH, unsigned DEPTH, typename LIE>
+LIE load_lie(const algebra_view& view)
+{
+	const algebra_file_header& h = view.header();
+	if (h.kind != algebra_file::LIE_KIND || h.width != WIDTH || h.depth != DEPTH || h.dimension != hall_layout<WIDTH, DEPTH>::size())
+		throw std::runtime_error("load_lie: the file holds a different algebra");
+	LIE ans;
+	for (size_t i = 0; i < view.count(); ++i) {
+		const double v = view.value(i);
+		if (v != 0.)
+			ans[typename LIE::KEY(view.index(i) + 1)] = typename LIE::SCALAR(v);
+	}
+	return ans;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <stddef.h> //size_t
+#include "libalgebra/alg_types.h"
+
+// compile time dimensions of the truncated tensor and Hall (free lie) bases
+//
+// TENSOR::basis.size() and LIE::basis.size() are only known once the bases have been built;
+// the tables below give the same numbers, and the per degree offsets, as constant expressions
+// so that buffers can be sized statically and index arithmetic folds at compile time.
+// The tensor algebra over WIDTH letters has WIDTH^d words of degree d; the free lie algebra
+// has (1/d) sum_{k | d} mu(k) WIDTH^(d/k) Hall words of degree d (Witt's formula).
+
+namespace basis_dimensions {
+
+	/// base^exponent, as alg::ConstPower<base, exponent>::ans but usable with non template arguments
+	constexpr unsigned long long power(unsigned long long base, unsigned exponent)
+	{
+		unsigned long long ans = 1;
+		for (unsigned i = 0; i < exponent; ++i)
+			ans *= base;
+		return ans;
+	}
+
+	/// the Moebius function
+	constexpr int moebius(unsigned n)
+	{
+		int ans = 1;
+		for (unsigned p = 2; p * p <= n; ++p)
+			if (n % p == 0) {
+				n /= p;
+				if (n % p == 0)
+					return 0;
+				ans = -ans;
+			}
+		return (n > 1) ? -ans : ans;
+	}
+
+	/// the number of words of degree d
+	constexpr unsigned long long tensor_level_size(unsigned width, unsigned d)
+	{
+		return power(width, d);
+	}
+
+	/// the number of Hall basis elements of degree d >= 1 (Witt's formula)
+	constexpr unsigned long long hall_level_size(unsigned width, unsigned d)
+	{
+		if (d == 0)
+			return 0;
+		long long ans = 0;
+		for (unsigned k = 1; k <= d; ++k)
+			if (d % k == 0)
+				ans += moebius(k) * (long long)power(width, d / k);
+		return (unsigned long long)(ans / d);
+	}
+
+	/// a table of DEPTH + 2 values indexed by degree
+	template <unsigned DEPTH>
+	struct degree_table
+	{
+		size_t value[DEPTH + 2];
+		constexpr size_t operator[](unsigned d) const { return value[d]; }
+	};
+
+	/// the tensor level offsets: value[d] is the number of words of degree < d
+	template <unsigned WIDTH, unsigned DEPTH>
+	constexpr degree_table<DEPTH> tensor_offsets()
+	{
+		degree_table<DEPTH> ans{};
+		for (unsigned d = 1; d <= DEPTH + 1; ++d)
+			ans.value[d] = ans.value[d - 1] + size_t(tensor_level_size(WIDTH, d - 1));
+		return ans;
+	}
+
+	/// the Hall basis offsets: value[d] is the number of Hall elements of degree 1..d-1 (no degree 0)
+	template <unsigned WIDTH, unsigned DEPTH>
+	constexpr degree_table<DEPTH> hall_offsets()
+	{
+		degree_table<DEPTH> ans{};
+		for (unsigned d = 2; d <= DEPTH + 1; ++d)
+			ans.value[d] = ans.value[d - 1] + size_t(hall_level_size(WIDTH, d - 1));
+		return ans;
+	}
+
+} // namespace basis_dimensions
+
+/// ConstTensorDimension<WIDTH, DEPTH>::ans == TENSOR::basis.size(), in the style of alg::ConstPower
+template <unsigned WIDTH, unsigned DEPTH>
+struct ConstTensorDimension
+{
+	static const unsigned long long ans = alg::ConstPower<WIDTH, DEPTH>::ans + ConstTensorDimension<WIDTH, DEPTH - 1>::ans;
+};
+
+template <unsigned WIDTH>
+struct ConstTensorDimension<WIDTH, 0>
+{
+	static const unsigned long long ans = 1;
+};
+
+/// ConstHallDimension<WIDTH, DEPTH>::ans == LIE::basis.size()
+template <unsigned WIDTH, unsigned DEPTH>
+struct ConstHallDimension
+{
+	static const unsigned long long ans = basis_dimensions::hall_level_size(WIDTH, DEPTH) + ConstHallDimension<WIDTH, DEPTH - 1>::ans;
+};
+
+template <unsigned WIDTH>
+struct ConstHallDimension<WIDTH, 0>
+{
+	static const unsigned long long ans = 0;
+};
+
+/// hall_layout - the degree ranges of the Hall basis truncated at DEPTH over WIDTH letters
+template <unsigned WIDTH, unsigned DEPTH>
+struct hall_layout
+{
+	/// the number of Hall elements of degree d >= 1
+	static constexpr size_t level_size(unsigned d)
+	{
+		return offsets[d + 1] - offsets[d];
+	}
+
+	/// the number of Hall elements of degree < d
+	static constexpr size_t offset(unsigned d)
+	{
+		return offsets[d];
+	}
+
+	/// the dimension of the truncated free lie algebra
+	static constexpr size_t size()
+	{
+		return offsets[DEPTH + 1];
+	}
+
+	static constexpr basis_dimensions::degree_table<DEPTH> offsets = basis_dimensions::hall_offsets<WIDTH, DEPTH>();
+};
+
+template <unsigned WIDTH, unsigned DEPTH>
+constexpr basis_dimensions::degree_table<DEPTH> hall_layout<WIDTH, DEPTH>::offsets;
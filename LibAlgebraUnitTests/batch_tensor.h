@@ -0,0 +1,199 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "tensor_layout.h"
+
+/// batch_tensor - the truncated tensors of a batch of paths in structure of arrays form
+///
+/// coefficient k (in the tensor_layout order) of the batch() tensors occupies the batch() contiguous
+/// doubles coefficient(k)[0..batch()), so every kernel below runs its innermost loop across the
+/// batch with unit stride, which the compiler vectorises however small the levels are
+/// (e.g. thousands of short width 2 paths, where a level holds only 2, 4 or 8 coefficients).
+///
+template <unsigned WIDTH, unsigned DEPTH>
+class batch_tensor
+{
+public:
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+
+	// constructor: batch copies of the scalar s
+	explicit batch_tensor(size_t batch, double s = 0.)
+		: n(batch), data(LAYOUT::size() * batch, 0.)
+	{
+		std::fill(coefficient(0), coefficient(0) + n, s);
+	}
+
+	// accessors
+	size_t batch() const { return n; }
+	double* coefficient(size_t k) { return &data[k * n]; }
+	const double* coefficient(size_t k) const { return &data[k * n]; }
+	double* level(unsigned d) { return coefficient(LAYOUT::offset(d)); }
+	const double* level(unsigned d) const { return coefficient(LAYOUT::offset(d)); }
+
+	/// replaces tensor p of the batch with a sparse TENSOR
+	template <typename TENSOR>
+	void assign(size_t p, const TENSOR& arg)
+	{
+		for (size_t k = 0; k < LAYOUT::size(); ++k)
+			coefficient(k)[p] = 0.;
+		for (const auto& k : arg)
+			coefficient(LAYOUT::template index<TENSOR>(k.first))[p] = double(k.second);
+	}
+
+	/// tensor p of the batch as a sparse TENSOR
+	template <typename TENSOR>
+	TENSOR to_tensor(size_t p) const
+	{
+		TENSOR ans;
+		for (unsigned d = 0; d <= DEPTH; ++d)
+			for (size_t i = 0; i < LAYOUT::level_size(d); ++i) {
+				const double c = level(d)[i * n + p];
+				if (c != 0.)
+					ans[LAYOUT::template key<TENSOR>(d, i)] = typename TENSOR::SCALAR(c);
+			}
+		return ans;
+	}
+
+	/// this = this * rhs truncated at DEPTH, path by path, in place from the top degree down
+	batch_tensor& operator*=(const batch_tensor& rhs)
+	{
+		if (&rhs == this) {
+			const batch_tensor copy(rhs);
+			return *this *= copy;
+		}
+		const double* unit = rhs.coefficient(0);
+		for (unsigned d = DEPTH + 1; d-- > 0;) {
+			double* out = level(d);
+			for (size_t j = 0; j < LAYOUT::level_size(d); ++j)
+				scale(out + j * n, unit);
+			for (unsigned i = 0; i < d; ++i) {
+				const size_t nb = LAYOUT::level_size(d - i);
+				for (size_t a = 0; a < LAYOUT::level_size(i); ++a)
+					for (size_t b = 0; b < nb; ++b)
+						multiply_add(out + (a * nb + b) * n, level(i) + a * n, rhs.level(d - i) + b * n);
+			}
+		}
+		return *this;
+	}
+
+	/// Chen's identity: this <- this * exp(x) for the degree one increments x[j * batch() + p], j < WIDTH
+	///
+	/// new degree d is sum_i S_i (x) x^(d-i) / (d-i)!, formed without exp(x) by the Horner recursion
+	/// B_0 = S_0, B_k = S_k + B_(k-1) (x) x / (d-k+1), new S_d = B_d
+	void chen_update(const double* x)
+	{
+		horner.resize(2 * LAYOUT::level_size(DEPTH) * n);
+		for (unsigned d = DEPTH; d >= 1; --d) {
+			const double* previous = level(0);
+			for (unsigned k = 1; k <= d; ++k) {
+				double* next = (k == d) ? level(d) : &horner[(k % 2) * LAYOUT::level_size(DEPTH) * n];
+				const double* s = level(k);
+				const double c = 1. / double(d - k + 1);
+				for (size_t a = 0; a < LAYOUT::level_size(k - 1); ++a)
+					for (size_t b = 0; b < WIDTH; ++b) {
+						double* o = next + (a * WIDTH + b) * n;
+						const double* s_ab = s + (a * WIDTH + b) * n;
+						const double* p_a = previous + a * n;
+						const double* x_b = x + b * n;
+						for (size_t p = 0; p < n; ++p)
+							o[p] = s_ab[p] + p_a[p] * x_b[p] * c;
+					}
+				previous = next;
+			}
+		}
+	}
+
+	/// exchanges the content of two batches
+	void swap(batch_tensor& rhs)
+	{
+		std::swap(n, rhs.n);
+		data.swap(rhs.data);
+	}
+
+	/// x <- exp(x) for a batch with no scalar parts; h is scratch of the same batch size
+	friend void exp_inplace(batch_tensor& x, batch_tensor& h)
+	{
+		// h is a polynomial in x so x h = h x, and the Horner step h <- 1 + x h / k is formed in place in h
+		h.fill_scalar(1.);
+		for (unsigned k = DEPTH; k >= 1; --k) {
+			h *= x;
+			const double c = 1. / double(k);
+			for (double& v : h.data)
+				v *= c;
+			std::fill(h.coefficient(0), h.coefficient(0) + h.n, 1.);
+		}
+		x.swap(h);
+	}
+
+	/// g <- log(g) for a batch with scalar parts one; h is scratch of the same batch size
+	friend void log_inplace(batch_tensor& g, batch_tensor& h)
+	{
+		// with x = g - 1, h <- 1/k - x h for k = DEPTH - 1..1 and then log(g) = x h = h x
+		std::fill(g.coefficient(0), g.coefficient(0) + g.n, 0.);
+		h.fill_scalar(1. / double(DEPTH));
+		for (unsigned k = DEPTH - 1; k >= 1; --k) {
+			h *= g;
+			for (double& v : h.data)
+				v = -v;
+			std::fill(h.coefficient(0), h.coefficient(0) + h.n, 1. / double(k));
+		}
+		h *= g;
+		g.swap(h);
+	}
+
+private:
+	size_t n;
+	std::vector<double> data;
+	std::vector<double> horner;
+
+	void fill_scalar(double s)
+	{
+		std::fill(data.begin(), data.end(), 0.);
+		std::fill(coefficient(0), coefficient(0) + n, s);
+	}
+
+	void scale(double* out, const double* s) const
+	{
+		for (size_t p = 0; p < n; ++p)
+			out[p] *= s[p];
+	}
+
+	void multiply_add(double* out, const double* a, const double* b) const
+	{
+		for (size_t p = 0; p < n; ++p)
+			out[p] += a[p] * b[p];
+	}
+};
+
+/// the signatures of a batch of paths from their increments in the makebm_batch layout
+/// increments[(i * WIDTH + j) * batch + p], i < steps
+template <unsigned WIDTH, unsigned DEPTH>
+batch_tensor<WIDTH, DEPTH> batch_signature(const double* increments, size_t steps, size_t batch)
+{
+	batch_tensor<WIDTH, DEPTH> ans(batch, 1.);
+	for (size_t i = 0; i < steps; ++i)
+		ans.chen_update(increments + i * WIDTH * batch);
+	return ans;
+}
+
+/// the Dynkin map t2l applied path by path: ans[(k - 1) * batch + p] is the coefficient of the
+/// Hall basis element k in maps.t2l of tensor p; the right bracketings of the words are found once
+template <typename FRAMEWORK, unsigned WIDTH, unsigned DEPTH>
+void batch_t2l(const batch_tensor<WIDTH, DEPTH>& arg, const FRAMEWORK& context, std::vector<double>& ans)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	const size_t n = arg.batch();
+	ans.assign(LIE::basis.size() * n, 0.);
+	for (unsigned d = 1; d <= DEPTH; ++d)
+		for (size_t i = 0; i < LAYOUT::level_size(d); ++i) {
+			const double* w = arg.level(d) + i * n;
+			for (const auto& l : context.maps.rbraketing(LAYOUT::template key<TENSOR>(d, i))) {
+				double* out = &ans[(size_t(l.first) - 1) * n];
+				const double c = double(l.second) / double(d);
+				for (size_t p = 0; p < n; ++p)
+					out[p] += w[p] * c;
+			}
+		}
+}
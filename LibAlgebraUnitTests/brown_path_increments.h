@@ -21,6 +21,18 @@
 			}
 		}
 
+		// generates the increments of the counter based brownian path of the seed (makebm_increments), in parallel
+		brown_path_increments(philox_seed seed, const unsigned steps = STEPS) : increments(steps)
+		{
+			std::vector<double> x(size_t(steps) * ALPHABET_SIZE);
+			makebm_increments(x.data(), 0, steps, steps, ALPHABET_SIZE, seed);
+			const ptrdiff_t N = ptrdiff_t(steps);
+#pragma omp parallel for
+			for (ptrdiff_t i = 0; i < N; ++i)
+				for (size_t j = 0; j < ALPHABET_SIZE; j++)
+					increments[size_t(i)] += LIE(j + 1, x[size_t(i) * ALPHABET_SIZE + j]);
+		}
+
 		typedef typename alg_framework<DEPTH, ALPHABET_SIZE, DPReal>::TENSOR TENSOR;
 		typedef typename alg_framework<DEPTH, ALPHABET_SIZE, DPReal>::S S;
 		using alg_framework<DEPTH, ALPHABET_SIZE, DPReal>::maps;
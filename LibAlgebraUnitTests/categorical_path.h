@@ -1,6 +1,9 @@
 #pragma once
 // the libalgebra framework
 #include "alg_framework.h"
+#include "philox.h"
+#include <random>
+#include <vector>
 
 template <typename alg::LET depth, typename alg::LET width, coefficient_t  S_t = Rational>
 struct sigtools: alg_framework <depth, width, S_t>
@@ -86,6 +89,20 @@ struct categorical_path : sigtools<DEPTH, ALPHABET_SIZE, S_t>
 		//	increments[i] = LIE(distribution(generator), S(1));
 			increments[i] = LIE(1+generator() %ALPHABET_SIZE, S(1));
 	}
+
+	// constructor
+	// the letters of the counter based stream of the seed (philox_letter), made in parallel
+	categorical_path(philox_seed seed, size_t STPS = ALPHABET_SIZE) :
+		steps(STPS),
+		width(ALPHABET_SIZE),
+		depth(DEPTH),
+		increments(Steps(), LIE())
+	{
+		const ptrdiff_t N = ptrdiff_t(Steps());
+#pragma omp parallel for
+		for (ptrdiff_t i = 0; i < N; ++i)
+			increments[size_t(i)] = LIE(typename LIE::KEY(philox_letter(seed, uint64_t(i), ALPHABET_SIZE)), S(1));
+	}
 };
 
 // ? OMP
@@ -0,0 +1,79 @@
+#pragma once
+#include <memory>
+#include <utility>
+
+/// cow_vector - a reference counted, copy-on-write handle to a TENSOR or LIE
+///
+/// copies and assignments of a handle share a single instance and cost O(1)
+/// whatever the size of the vector; read access never copies.
+/// The storage is only duplicated when a handle that shares its instance is mutated
+/// through mutate() or one of the in-place operators.
+///
+/// As with any reference counted object, a handle that is being mutated should not
+/// be copied concurrently by another thread; distinct handles can be used freely in parallel.
+///
+template <typename VECTOR_T>
+class cow_vector
+{
+	std::shared_ptr<VECTOR_T> p;
+
+public:
+	typedef VECTOR_T value_type;
+
+	// constructors
+	cow_vector() : p(std::make_shared<VECTOR_T>()) {}
+	explicit cow_vector(const VECTOR_T& arg) : p(std::make_shared<VECTOR_T>(arg)) {}
+	explicit cow_vector(VECTOR_T&& arg) : p(std::make_shared<VECTOR_T>(std::move(arg))) {}
+
+	// read only access (never copies)
+	const VECTOR_T& operator*() const { return *p; }
+	const VECTOR_T* operator->() const { return p.get(); }
+	operator const VECTOR_T& () const { return *p; }
+
+	/// write access; duplicates the storage first if it is shared with another handle
+	VECTOR_T& mutate()
+	{
+		if (p.use_count() > 1)
+			p = std::make_shared<VECTOR_T>(*p);
+		return *p;
+	}
+
+	/// moves the value out if this is the only handle, otherwise copies it
+	VECTOR_T release()
+	{
+		VECTOR_T ans((p.use_count() > 1) ? VECTOR_T(*p) : std::move(*p));
+		p = std::make_shared<VECTOR_T>();
+		return ans;
+	}
+
+	// sharing
+	bool shares(const cow_vector& rhs) const { return p == rhs.p; }
+	long use_count() const { return p.use_count(); }
+
+	// in-place arithmetic (duplicates shared storage before writing)
+	template <typename T>
+	cow_vector& operator*=(const T& rhs) { mutate() *= rhs; return *this; }
+	cow_vector& operator*=(const cow_vector& rhs) { mutate() *= *rhs; return *this; }
+	template <typename T>
+	cow_vector& operator+=(const T& rhs) { mutate() += rhs; return *this; }
+	cow_vector& operator+=(const cow_vector& rhs) { mutate() += *rhs; return *this; }
+	template <typename T>
+	cow_vector& operator-=(const T& rhs) { mutate() -= rhs; return *this; }
+	cow_vector& operator-=(const cow_vector& rhs) { mutate() -= *rhs; return *this; }
+
+	// out of place products create a new unshared instance
+	friend cow_vector operator*(const cow_vector& lhs, const cow_vector& rhs)
+	{
+		return cow_vector(VECTOR_T(*lhs * *rhs));
+	}
+
+	friend bool operator==(const cow_vector& lhs, const cow_vector& rhs)
+	{
+		return lhs.shares(rhs) || *lhs == *rhs;
+	}
+
+	friend bool operator!=(const cow_vector& lhs, const cow_vector& rhs)
+	{
+		return !(lhs == rhs);
+	}
+};
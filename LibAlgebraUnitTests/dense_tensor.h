@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <algorithm>
+#include "tensor_layout.h"
+
+/// dense_tensor - a truncated tensor held as one contiguous buffer in the tensor_layout order
+///
+/// products are formed in place in the left operand from the top degree down, so that
+/// signature *= increment holds one tensor plus the increment rather than three full tensors
+///
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+class dense_tensor
+{
+public:
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+
+	// constructors
+	dense_tensor() : data(LAYOUT::size(), SCALAR(0)) {}
+	explicit dense_tensor(const SCALAR& s) : data(LAYOUT::size(), SCALAR(0)) { data[0] = s; }
+
+	// accessors
+	SCALAR* level(unsigned d) { return &data[LAYOUT::offset(d)]; }
+	const SCALAR* level(unsigned d) const { return &data[LAYOUT::offset(d)]; }
+	SCALAR& operator[](size_t i) { return data[i]; }
+	const SCALAR& operator[](size_t i) const { return data[i]; }
+	size_t size() const { return data.size(); }
+
+	/// replaces the content with a sparse TENSOR
+	template <typename TENSOR>
+	void assign(const TENSOR& arg)
+	{
+		std::fill(data.begin(), data.end(), SCALAR(0));
+		for (const auto& k : arg)
+			data[LAYOUT::template index<TENSOR>(k.first)] = k.second;
+	}
+
+	/// the sparse TENSOR with the same (non zero) coefficients
+	template <typename TENSOR>
+	TENSOR to_tensor() const
+	{
+		TENSOR ans;
+		for (unsigned d = 0; d <= DEPTH; ++d) {
+			const SCALAR* l = level(d);
+			for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+				if (l[i] != SCALAR(0))
+					ans[LAYOUT::template key<TENSOR>(d, i)] = l[i];
+		}
+		return ans;
+	}
+
+	/// this = this * rhs truncated at DEPTH, in place
+	dense_tensor& operator*=(const dense_tensor& rhs)
+	{
+		if (&rhs == this) {
+			const dense_tensor copy(rhs);
+			multiply_inplace<WIDTH, DEPTH>(*this, copy);
+		}
+		else
+			multiply_inplace<WIDTH, DEPTH>(*this, rhs);
+		return *this;
+	}
+
+	/// this = this * rhs truncated at DEPTH, in place, for a sparse TENSOR rhs
+	template <typename TENSOR>
+	dense_tensor& operator*=(const TENSOR& rhs)
+	{
+		multiply_inplace_sparse<WIDTH, DEPTH>(*this, rhs);
+		return *this;
+	}
+
+	/// exchanges the storage of two tensors
+	void swap(dense_tensor& rhs)
+	{
+		data.swap(rhs.data);
+	}
+
+	friend bool operator==(const dense_tensor& lhs, const dense_tensor& rhs)
+	{
+		return lhs.data == rhs.data;
+	}
+
+private:
+	std::vector<SCALAR> data;
+};
+
+/// the lowest degree >= 1 in which arg has a non zero coefficient, or DEPTH + 1 if there is none
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+unsigned min_degree(const dense_tensor<SCALAR, WIDTH, DEPTH>& arg)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	for (unsigned d = 1; d <= DEPTH; ++d) {
+		const SCALAR* l = arg.level(d);
+		for (size_t j = 0; j < LAYOUT::level_size(d); ++j)
+			if (l[j] != SCALAR(0))
+				return d;
+	}
+	return DEPTH + 1;
+}
+
+// the level aware series below work with x having no scalar part and lowest non zero degree m, so that
+// x^k starts in degree k m: only DEPTH / m terms of a series can contribute, a bracket multiplied on the
+// left by k factors of x is only needed in degrees <= DEPTH - k m, and zero degrees of x are skipped.
+// Each bracket is updated in place in a single scratch tensor from the top degree down, as degree d
+// of x h only reads degrees < d of h.
+
+/// h <- c + s x h in degrees 0..top, in place; x has no scalar part and nonzero[i] flags its non zero degrees
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+void horner_step(dense_tensor<SCALAR, WIDTH, DEPTH>& h, const dense_tensor<SCALAR, WIDTH, DEPTH>& x
+	, const std::array<bool, DEPTH + 1>& nonzero, unsigned top, const SCALAR& c, const SCALAR& s)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	for (unsigned d = top; d >= 1; --d) {
+		SCALAR* out = h.level(d);
+		std::fill(out, out + LAYOUT::level_size(d), SCALAR(0));
+		for (unsigned i = 1; i <= d; ++i)
+			if (nonzero[i])
+				outer_product_add(out, x.level(i), LAYOUT::level_size(i), h.level(d - i), LAYOUT::level_size(d - i));
+		for (size_t j = 0; j < LAYOUT::level_size(d); ++j)
+			out[j] *= s;
+	}
+	h[0] = c;
+}
+
+/// the flags of the non zero degrees of arg
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+std::array<bool, DEPTH + 1> nonzero_degrees(const dense_tensor<SCALAR, WIDTH, DEPTH>& arg)
+{
+	std::array<bool, DEPTH + 1> ans;
+	ans.fill(false);
+	for (unsigned d = min_degree(arg); d <= DEPTH; ++d) {
+		const SCALAR* l = arg.level(d);
+		ans[d] = std::any_of(l, l + tensor_layout<WIDTH, DEPTH>::level_size(d), [](const SCALAR& c) {return c != SCALAR(0); });
+	}
+	return ans;
+}
+
+/// x <- exp(x) for a dense tensor x with no scalar part, such as the tensor expansion of a lie element
+///
+/// uses the Horner form exp(x) = 1 + x (1 + x/2 (1 + ... (1 + x/N))), N = DEPTH / m, built in the
+/// scratch tensor h which callers can reuse between calls
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+void exp_inplace(dense_tensor<SCALAR, WIDTH, DEPTH>& x, dense_tensor<SCALAR, WIDTH, DEPTH>& h)
+{
+	const unsigned m = min_degree(x);
+	std::fill(h.level(0), h.level(0) + h.size(), SCALAR(0));
+	h[0] = SCALAR(1);
+	if (m <= DEPTH) {
+		const std::array<bool, DEPTH + 1> nonzero = nonzero_degrees(x);
+		// the k-th bracket is multiplied on the left by k - 1 factors of x
+		for (unsigned k = DEPTH / m; k >= 1; --k) {
+			const SCALAR s = SCALAR(1) / SCALAR(k);
+			horner_step(h, x, nonzero, DEPTH - (k - 1) * m, SCALAR(1), s);
+		}
+	}
+	x.swap(h);
+}
+
+/// exp(x) for a dense tensor x with no scalar part
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+dense_tensor<SCALAR, WIDTH, DEPTH> exp(const dense_tensor<SCALAR, WIDTH, DEPTH>& x)
+{
+	dense_tensor<SCALAR, WIDTH, DEPTH> ans(x), h;
+	exp_inplace(ans, h);
+	return ans;
+}
+
+/// g <- log(g) for a dense tensor g with scalar part one, such as a signature
+///
+/// with x = g - 1 uses the Horner form log(1 + x) = x (1 - x (1/2 - x (1/3 - ... x/N))), N = DEPTH / m,
+/// built in the scratch tensor h which callers can reuse between calls
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+void log_inplace(dense_tensor<SCALAR, WIDTH, DEPTH>& g, dense_tensor<SCALAR, WIDTH, DEPTH>& h)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	// x = g - 1 lives in degrees 1..DEPTH of g
+	g[0] = SCALAR(0);
+	const unsigned m = min_degree(g);
+	if (m > DEPTH)
+		return;
+	const std::array<bool, DEPTH + 1> nonzero = nonzero_degrees(g);
+	const unsigned N = DEPTH / m;
+	std::fill(h.level(0), h.level(0) + h.size(), SCALAR(0));
+	h[0] = SCALAR(1) / SCALAR(N);
+	// the k-th bracket is multiplied on the left by k factors of x
+	for (unsigned k = N - 1; k >= 1; --k) {
+		const SCALAR c = SCALAR(1) / SCALAR(k);
+		horner_step(h, g, nonzero, DEPTH - k * m, c, SCALAR(-1));
+	}
+	// g <- x h, top down; degree d reads x_d h_0 and x_i, i < d, which are still unmodified
+	for (unsigned d = DEPTH; d >= m; --d) {
+		SCALAR* out = g.level(d);
+		for (size_t j = 0; j < LAYOUT::level_size(d); ++j)
+			out[j] *= h[0];
+		for (unsigned i = m; i < d; ++i)
+			if (nonzero[i])
+				outer_product_add(out, g.level(i), LAYOUT::level_size(i), h.level(d - i), LAYOUT::level_size(d - i));
+	}
+}
+
+/// log(g) for a dense tensor g with scalar part one
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+dense_tensor<SCALAR, WIDTH, DEPTH> log(const dense_tensor<SCALAR, WIDTH, DEPTH>& g)
+{
+	dense_tensor<SCALAR, WIDTH, DEPTH> ans(g), h;
+	log_inplace(ans, h);
+	return ans;
+}
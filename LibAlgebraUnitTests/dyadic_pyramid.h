@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <stddef.h> //size_t
+#include "cow_vector.h"
+#include "tensor_layout.h"
+#include "feature_matrix.h"
+
+/// dyadic_pyramid - the signatures (or logsignatures) of the dyadic blocks of a path at every scale
+///
+/// block j of level l covers the increments [j 2^l, min((j + 1) 2^l, steps)); level 0 holds the
+/// exponentials of the increments and the single block of the top level is the whole path.
+/// Only the ceil(steps / 2^l) blocks of level l that meet the path are kept, and a block with a
+/// single child shares the child's storage.
+template <typename ALGEBRA>
+class dyadic_pyramid
+{
+public:
+	// constructor
+	// a path of at least one increment; the blocks are empty until set
+	explicit dyadic_pyramid(size_t steps) : n(steps)
+	{
+		assert(steps > 0);
+		size_t count = n;
+		offsets.push_back(0);
+		while (true) {
+			offsets.push_back(offsets.back() + count);
+			if (count <= 1)
+				break;
+			count = (count + 1) / 2;
+		}
+		blocks.resize(offsets.back());
+	}
+
+	// dimensions
+	size_t steps() const { return n; }
+	unsigned levels() const { return unsigned(offsets.size() - 1); }
+	size_t level_size(unsigned l) const { return offsets[l + 1] - offsets[l]; }
+	size_t size() const { return blocks.size(); }
+
+	/// the position of block j of level l, level 0 first; also its row in write_pyramid
+	size_t index(unsigned l, size_t j) const { return offsets[l] + j; }
+
+	/// the increments [block_begin, block_end) of block j of level l
+	size_t block_begin(unsigned l, size_t j) const { return j << l; }
+	size_t block_end(unsigned l, size_t j) const { return std::min((j + 1) << l, n); }
+
+	/// true if block j of level l > 0 has only one child, and so equals it
+	bool single_child(unsigned l, size_t j) const { return l > 0 && 2 * j + 1 == level_size(l - 1); }
+
+	// the blocks
+	const ALGEBRA& operator()(unsigned l, size_t j) const { return *blocks[index(l, j)]; }
+	const ALGEBRA& root() const { return *blocks.back(); }
+	cow_vector<ALGEBRA>& at(size_t i) { return blocks[i]; }
+	const cow_vector<ALGEBRA>& at(size_t i) const { return blocks[i]; }
+
+private:
+	size_t n;
+	std::vector<size_t> offsets;
+	std::vector<cow_vector<ALGEBRA>> blocks;
+};
+
+/// writes a signature pyramid to a feature_matrix with TENSOR::basis.size() columns in the tensor_layout
+/// order; block (l, j) goes to row index(l, j)
+template <unsigned WIDTH, unsigned DEPTH, typename TENSOR>
+void write_pyramid(const dyadic_pyramid<TENSOR>& pyramid, feature_matrix& matrix)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	if (matrix.columns() != LAYOUT::size() || matrix.rows() < pyramid.size())
+		throw std::runtime_error("write_pyramid: the matrix does not fit the pyramid");
+	const ptrdiff_t N = ptrdiff_t(pyramid.size());
+#pragma omp parallel for
+	for (ptrdiff_t i = 0; i < N; ++i) {
+		float* row = matrix.row(size_t(i));
+		std::fill(row, row + matrix.columns(), 0.f);
+		for (const auto& k : *pyramid.at(size_t(i)))
+			row[LAYOUT::template index<TENSOR>(k.first)] = float(k.second);
+	}
+}
+
+/// writes a logsignature pyramid to a feature_matrix with LIE::basis.size() columns, column k - 1 being
+/// Hall element k; block (l, j) goes to row index(l, j)
+template <typename LIE>
+void write_lie_pyramid(const dyadic_pyramid<LIE>& pyramid, feature_matrix& matrix)
+{
+	if (matrix.columns() != LIE::basis.size() || matrix.rows() < pyramid.size())
+		throw std::runtime_error("write_lie_pyramid: the matrix does not fit the pyramid");
+	const ptrdiff_t N = ptrdiff_t(pyramid.size());
+#pragma omp parallel for
+	for (ptrdiff_t i = 0; i < N; ++i) {
+		float* row = matrix.row(size_t(i));
+		std::fill(row, row + matrix.columns(), 0.f);
+		for (const auto& k : *pyramid.at(size_t(i)))
+			row[size_t(k.first) - 1] = float(k.second);
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <stddef.h> //size_t
+#include <omp.h>
+#include "tensor_layout.h"
+#include "dense_tensor.h"
+#include "makebm.h"
+
+/// signature_moments - a Monte Carlo estimate of the expected signature in the tensor_layout order
+template <unsigned WIDTH, unsigned DEPTH>
+struct signature_moments
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+
+	size_t samples = 0;
+	std::vector<double> mean;				// the sample mean of each coordinate
+	std::vector<double> standard_error;		// of each mean; empty unless second moments were accumulated
+
+	/// the mean as a sparse TENSOR
+	template <typename TENSOR>
+	TENSOR mean_tensor() const
+	{
+		TENSOR ans;
+		for (unsigned d = 0; d <= DEPTH; ++d)
+			for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+				if (mean[LAYOUT::offset(d) + i] != 0.)
+					ans[LAYOUT::template key<TENSOR>(d, i)] = typename TENSOR::SCALAR(mean[LAYOUT::offset(d) + i]);
+		return ans;
+	}
+};
+
+/// estimates the expected signature of brownian motion on [0, 1] over n_paths paths of steps increments;
+/// path p is the counter based path makebm_increments_serial of the seed philox_seed{ seed.value + p }.
+///
+/// each thread updates one dense signature per path and keeps running (Welford) means and, if asked, sums of
+/// squared deviations of the paths it is given, so memory is a few tensors per thread whatever n_paths.
+/// The per thread partials are merged in thread order, so the result is reproducible for a number of threads.
+template <unsigned WIDTH, unsigned DEPTH>
+signature_moments<WIDTH, DEPTH> monte_carlo_expected_signature(size_t n_paths, size_t steps, philox_seed seed, bool second_moments = true)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	typedef dense_tensor<double, WIDTH, DEPTH> DENSE;
+	const size_t size = LAYOUT::size();
+	const int threads = omp_get_max_threads();
+	std::vector<size_t> counts(threads, 0);
+	std::vector<std::vector<double>> means(threads), squares(threads);
+	const ptrdiff_t N = ptrdiff_t(n_paths);
+#pragma omp parallel num_threads(threads)
+	{
+		const int t = omp_get_thread_num();
+		std::vector<double>& mean = means[t];
+		std::vector<double>& square = squares[t];
+		mean.assign(size, 0.);
+		square.assign(second_moments ? size : 0, 0.);
+		DENSE signature;
+		std::vector<double> x(steps * WIDTH), scratch;
+#pragma omp for schedule(static)
+		for (ptrdiff_t p = 0; p < N; ++p) {
+			makebm_increments_serial(x.data(), 0, steps, steps, WIDTH, philox_seed{ seed.value + uint64_t(p) });
+			std::fill(&signature[0], &signature[0] + size, 0.);
+			signature[0] = 1.;
+			for (size_t i = 0; i < steps; ++i)
+				chen_update<WIDTH, DEPTH>(signature, &x[i * WIDTH], scratch);
+			const double k = double(++counts[t]);
+			for (size_t w = 0; w < size; ++w) {
+				const double delta = signature[w] - mean[w];
+				mean[w] += delta / k;
+				if (second_moments)
+					square[w] += delta * (signature[w] - mean[w]);
+			}
+		}
+	}
+
+	// the ordered merge (Chan et al.)
+	signature_moments<WIDTH, DEPTH> ans;
+	ans.mean.assign(size, 0.);
+	std::vector<double> square(second_moments ? size : 0, 0.);
+	for (int t = 0; t < threads; ++t) {
+		if (counts[t] == 0)
+			continue;
+		const double n = double(ans.samples), m = double(counts[t]), total = n + m;
+		for (size_t w = 0; w < size; ++w) {
+			const double delta = means[t][w] - ans.mean[w];
+			ans.mean[w] += delta * m / total;
+			if (second_moments)
+				square[w] += squares[t][w] + delta * delta * n * m / total;
+		}
+		ans.samples += counts[t];
+	}
+	if (second_moments && ans.samples > 1) {
+		ans.standard_error.resize(size);
+		for (size_t w = 0; w < size; ++w)
+			ans.standard_error[w] = std::sqrt(square[w] / double(ans.samples - 1) / double(ans.samples));
+	}
+	return ans;
+}
@@ -0,0 +1,51 @@
+#include "feature_matrix.h"
+#include <boost/filesystem/operations.hpp> // exists, remove
+#include <boost/filesystem/fstream.hpp>
+#include <stdexcept>
+
+feature_matrix::feature_matrix(boost::filesystem::path filename, size_t rows, size_t columns) : r(rows), c(columns)
+{
+	// always a fresh file of the full size
+	if (boost::filesystem::exists(filename))
+		boost::filesystem::remove(filename);
+	boost::iostreams::mapped_file_params params(filename.string());
+	params.new_file_size = boost::iostreams::stream_offset(rows * columns * sizeof(float));
+	file.open(params);
+	if (!(file.is_open()))
+		throw std::runtime_error("feature_matrix: cannot map " + filename.string());
+	data = (float*)file.data();
+}
+
+feature_matrix::~feature_matrix()
+{
+	file.close();
+}
+
+size_t feature_matrix::rows() const
+{
+	return r;
+}
+
+size_t feature_matrix::columns() const
+{
+	return c;
+}
+
+float* feature_matrix::row(size_t i)
+{
+	return data + i * c;
+}
+
+const float* feature_matrix::row(size_t i) const
+{
+	return data + i * c;
+}
+
+void write_feature_labels(boost::filesystem::path filename, const std::vector<std::string>& labels)
+{
+	boost::filesystem::ofstream file(filename, std::ios::trunc);
+	for (const auto& label : labels)
+		file << label << "\n";
+	if (!file)
+		throw std::runtime_error("write_feature_labels: cannot write " + filename.string());
+}
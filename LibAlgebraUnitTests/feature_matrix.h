@@ -0,0 +1,175 @@
+#pragma once
+// boost dependencies
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem/path.hpp>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <stddef.h> //size_t
+#include "tensor_layout.h"
+#include "dense_tensor.h"
+
+/// feature_matrix - a preallocated rows x columns row major matrix of floats in a memory mapped file
+///
+/// the file holds exactly rows * columns floats and nothing else, so it loads directly as e.g.
+/// numpy.memmap(filename, dtype=numpy.float32, shape=(rows, columns)); rows are disjoint so
+/// threads can fill different rows concurrently
+struct feature_matrix
+{
+public:
+	// constructor
+	// creates (or replaces) the file
+	feature_matrix(boost::filesystem::path filename, size_t rows, size_t columns);
+	~feature_matrix();
+
+	// accessors
+	size_t rows() const;
+	size_t columns() const;
+	float* row(size_t i);
+	const float* row(size_t i) const;
+
+private:
+	size_t const r;
+	size_t const c;
+	boost::iostreams::mapped_file_sink file;
+	float* data;
+};
+
+/// writes the column labels, one key2string per line, to the sidecar filename (e.g. "features.f32.columns")
+void write_feature_labels(boost::filesystem::path filename, const std::vector<std::string>& labels);
+
+/// the labels of the LIE columns: column k - 1 is the Hall basis element k
+template <typename LIE>
+std::vector<std::string> lie_feature_labels()
+{
+	std::vector<std::string> ans;
+	for (typename LIE::BASIS::KEY k = LIE::basis.begin(); k != LIE::basis.end(); k = LIE::basis.nextkey(k))
+		ans.push_back(LIE::basis.key2string(k));
+	return ans;
+}
+
+/// the labels of the TENSOR columns: the words in the tensor_layout order
+template <unsigned WIDTH, unsigned DEPTH, typename TENSOR>
+std::vector<std::string> tensor_feature_labels()
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	std::vector<std::string> ans;
+	for (unsigned d = 0; d <= DEPTH; ++d)
+		for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+			ans.push_back(TENSOR::basis.key2string(LAYOUT::template key<TENSOR>(d, i)));
+	return ans;
+}
+
+/// the Dynkin map t2l as a table: for the word at position i of the dense layout, entry i lists the
+/// (column, coefficient / degree) pairs of its right bracketing. Built once, it is read only and
+/// shared by the threads of an export (the MAPS caches are not thread safe).
+template <typename FRAMEWORK>
+std::vector<std::vector<std::pair<size_t, double>>> dynkin_table(const FRAMEWORK& context)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef tensor_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> LAYOUT;
+	std::vector<std::vector<std::pair<size_t, double>>> ans(LAYOUT::size());
+	for (unsigned d = 1; d <= FRAMEWORK::DEPTH; ++d)
+		for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+			for (const auto& l : context.maps.rbraketing(LAYOUT::template key<TENSOR>(d, i)))
+				ans[LAYOUT::offset(d) + i].emplace_back(size_t(l.first) - 1, double(l.second) / double(d));
+	return ans;
+}
+
+/// lie[k - 1] <- the coefficient of Hall element k in t2l(arg) for a dense tensor arg, by a dynkin_table
+template <typename DENSE>
+void dynkin_project(const std::vector<std::vector<std::pair<size_t, double>>>& table, const DENSE& arg, std::vector<double>& lie)
+{
+	std::fill(lie.begin(), lie.end(), 0.);
+	for (size_t w = 1; w < table.size(); ++w)
+		if (arg[w] != 0)
+			for (const auto& e : table[w])
+				lie[e.first] += double(arg[w]) * e.second;
+}
+
+/// exports the signatures (log_signatures false) or logsignatures of n_paths paths to the rows
+/// first_row.. of a matrix with TENSOR::basis.size() or LIE::basis.size() columns. Path p has
+/// steps + 1 points of ALPHABET_SIZE doubles at paths + p * (steps + 1) * ALPHABET_SIZE (makebm
+/// layout). Threads each reuse one dense signature and scratch and write straight into their rows.
+template <typename FRAMEWORK>
+void export_features(const double* paths, size_t n_paths, size_t steps, const FRAMEWORK& context
+	, feature_matrix& matrix, size_t first_row, bool log_signatures)
+{
+	typedef typename FRAMEWORK::S S;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	typedef tensor_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> LAYOUT;
+	if (matrix.columns() != (log_signatures ? hall_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>::size() : LAYOUT::size())
+		|| first_row + n_paths > matrix.rows())
+		throw std::runtime_error("export_features: the matrix does not fit the features");
+	const std::vector<std::vector<std::pair<size_t, double>>> table
+		= log_signatures ? dynkin_table(context) : std::vector<std::vector<std::pair<size_t, double>>>();
+	const ptrdiff_t N = ptrdiff_t(n_paths);
+#pragma omp parallel
+	{
+		DENSE signature, scratch;
+		std::vector<S> horner;
+		std::vector<double> lie(log_signatures ? matrix.columns() : 0);
+#pragma omp for
+		for (ptrdiff_t p = 0; p < N; ++p) {
+			const double* path = paths + size_t(p) * (steps + 1) * FRAMEWORK::ALPHABET_SIZE;
+			std::fill(&signature[0], &signature[0] + signature.size(), S(0));
+			signature[0] = S(1);
+			double x[FRAMEWORK::ALPHABET_SIZE];
+			for (size_t i = 0; i < steps; ++i) {
+				raw_increment<FRAMEWORK::ALPHABET_SIZE>(path + i * FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::ALPHABET_SIZE, true, x);
+				chen_update<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>(signature, x, horner);
+			}
+			float* row = matrix.row(first_row + size_t(p));
+			if (log_signatures) {
+				log_inplace(signature, scratch);
+				dynkin_project(table, signature, lie);
+				std::copy(lie.begin(), lie.end(), row);
+			}
+			else
+				for (size_t w = 0; w < LAYOUT::size(); ++w)
+					row[w] = float(signature[w]);
+		}
+	}
+}
+
+/// exports a batch of precomputed signatures [begin, end), or their logsignatures (log_signatures true), to
+/// the rows first_row.. of a matrix with TENSOR::basis.size() or LIE::basis.size() columns; the signatures
+/// are scattered straight into their rows and the logs use one dense scratch per thread
+template <typename ITERATOR_T, typename FRAMEWORK>
+void export_features(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context
+	, feature_matrix& matrix, size_t first_row, bool log_signatures)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::S S;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	typedef tensor_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> LAYOUT;
+	const ptrdiff_t N = end - begin;
+	if (matrix.columns() != (log_signatures ? hall_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>::size() : LAYOUT::size())
+		|| first_row + size_t(N) > matrix.rows())
+		throw std::runtime_error("export_features: the matrix does not fit the features");
+	const std::vector<std::vector<std::pair<size_t, double>>> table
+		= log_signatures ? dynkin_table(context) : std::vector<std::vector<std::pair<size_t, double>>>();
+#pragma omp parallel
+	{
+		DENSE logarithm, scratch;
+		std::vector<double> lie(log_signatures ? matrix.columns() : 0);
+#pragma omp for
+		for (ptrdiff_t p = 0; p < N; ++p) {
+			const TENSOR& sig = *(begin + p);
+			float* row = matrix.row(first_row + size_t(p));
+			if (log_signatures) {
+				logarithm.assign(sig);
+				log_inplace(logarithm, scratch);
+				dynkin_project(table, logarithm, lie);
+				std::copy(lie.begin(), lie.end(), row);
+			}
+			else {
+				std::fill(row, row + matrix.columns(), 0.f);
+				for (const auto& k : sig)
+					row[LAYOUT::template index<TENSOR>(k.first)] = float(k.second);
+			}
+		}
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "memfile.h"
+#include "algebra_file.h"
+
+// tolerance aware comparison of computed vectors with golden files
+//
+// unlike CHECK_compare_with_file, which rebuilds the file as a sparse vector and forms the difference,
+// these walk the computed vector and the mapped file side by side and only accumulate the maximum and
+// L1 deviations, so they allocate nothing whatever the size of the vector. When the computed vector
+// does not iterate in the file's order (a hashed vector, or a tensor against the layout order) the
+// file is walked in order and each stored coordinate looked up in memory instead.
+// The raw files are the sorted std::pair<KEY, SCALAR> arrays written by CHECK_compare_with_file;
+// algebra files (algebra_file.h) may use either the dense or the sparse encoding.
+
+/// the deviation between a computed vector and a golden file
+struct file_deviation
+{
+	double max = 0.;		// largest absolute difference of a coordinate
+	double l1 = 0.;			// sum of the absolute differences
+	size_t compared = 0;	// coordinates present in either
+
+	void add(double difference)
+	{
+		const double a = std::fabs(difference);
+		max = std::max(max, a);
+		l1 += a;
+		++compared;
+	}
+
+	bool within(double tolerance) const { return max <= tolerance; }
+};
+
+namespace golden_files_detail {
+
+	/// the deviation by one walk over the file in its own order, each stored coordinate looked up in sig
+	/// (a hash or tree lookup in memory); stored(f) calls f(key, value) for each stored coordinate.
+	/// Only if some computed coordinates were not met are they found by in_file(key), a lookup in the file
+	template <typename SPARSEVECTOR_T, typename STORED, typename IN_FILE>
+	file_deviation by_stored_walk(const SPARSEVECTOR_T& sig, STORED stored, IN_FILE in_file)
+	{
+		file_deviation ans;
+		size_t met = 0;
+		stored([&](const typename SPARSEVECTOR_T::KEY& key, double value) {
+			const auto found = sig.find(key);
+			if (found != sig.end()) {
+				ans.add(double(found->second) - value);
+				++met;
+			}
+			else if (value != 0.)
+				ans.add(value);
+		});
+		if (met < sig.size())
+			for (const auto& k : sig)
+				if (!in_file(k.first))
+					ans.add(double(k.second));
+		return ans;
+	}
+
+} // namespace golden_files_detail
+
+/// the deviation of sig from the raw golden file at filepath; as with CHECK_compare_with_file the
+/// file is made from sig on first call and is read only thereafter
+template <typename SPARSEVECTOR_T, typename PATH_T>
+file_deviation deviation_from_file(const SPARSEVECTOR_T& sig, const PATH_T& filepath)
+{
+	typedef typename std::pair< typename SPARSEVECTOR_T::KEY, typename SPARSEVECTOR_T::SCALAR > value_type;
+	memfile sigfile(filepath, sig.size() * sizeof(value_type));
+	value_type* data_begin = (value_type*)(sigfile.begin());
+	if (!sigfile.read_only()) {
+		std::copy(sig.begin(), sig.end(), data_begin);
+		std::sort(data_begin, data_begin + sig.size()
+			, [](const value_type& lhs, const value_type& rhs) {return lhs.first < rhs.first; });
+	}
+	const value_type* file_begin = data_begin;
+	const value_type* file_end = file_begin + sigfile.size() / sizeof(value_type);
+
+	// lockstep over the file and the computed vector, which iterates in key order when map based
+	file_deviation ans;
+	const value_type* f = file_begin;
+	bool ordered = true;
+	const typename SPARSEVECTOR_T::KEY* previous = nullptr;
+	for (auto k = sig.begin(); k != sig.end(); ++k) {
+		if (previous && k->first < *previous) {
+			ordered = false;
+			break;
+		}
+		previous = &k->first;
+		for (; f != file_end && f->first < k->first; ++f)
+			ans.add(double(f->second));
+		if (f != file_end && !(k->first < f->first))
+			ans.add(double(k->second) - double((f++)->second));
+		else
+			ans.add(double(k->second));
+	}
+	for (; ordered && f != file_end; ++f)
+		ans.add(double(f->second));
+	if (ordered)
+		return ans;
+
+	// a hashed vector: walk the file in order instead, looking up into sig
+	auto stored = [&](auto f) {
+		for (const value_type* i = file_begin; i != file_end; ++i)
+			f(i->first, double(i->second));
+	};
+	auto in_file = [&](const typename SPARSEVECTOR_T::KEY& key) {
+		const value_type* i = std::lower_bound(file_begin, file_end, key
+			, [](const value_type& lhs, const typename SPARSEVECTOR_T::KEY& rhs) {return lhs.first < rhs; });
+		return i != file_end && !(key < i->first);
+	};
+	return golden_files_detail::by_stored_walk(sig, stored, in_file);
+}
+
+/// the deviation of a TENSOR of width WIDTH truncated at DEPTH from an algebra file in either encoding
+template <unsigned WIDTH, unsigned DEPTH, typename TENSOR>
+file_deviation tensor_deviation_from_file(const TENSOR& sig, const algebra_view& view)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	if (view.header().kind != algebra_file::TENSOR_KIND || view.header().width != WIDTH || view.header().depth != DEPTH
+		|| view.header().dimension != LAYOUT::size())
+		throw std::runtime_error("tensor_deviation_from_file: the file holds a different algebra");
+	auto stored = [&](auto f) {
+		for (size_t i = 0; i < view.count(); ++i) {
+			const size_t index = size_t(view.index(i));
+			const unsigned d = LAYOUT::degree(index);
+			f(LAYOUT::template key<TENSOR>(d, index - LAYOUT::offset(d)), view.value(i));
+		}
+	};
+	auto in_file = [&](const typename TENSOR::KEY& key) {
+		double value;
+		return view.find(LAYOUT::template index<TENSOR>(key), value);
+	};
+	return golden_files_detail::by_stored_walk(sig, stored, in_file);
+}
+
+/// the deviation of a LIE of width WIDTH truncated at DEPTH from an algebra file in either encoding
+template <unsigned WIDTH, unsigned DEPTH, typename LIE>
+file_deviation lie_deviation_from_file(const LIE& logsig, const algebra_view& view)
+{
+	if (view.header().kind != algebra_file::LIE_KIND || view.header().width != WIDTH || view.header().depth != DEPTH
+		|| view.header().dimension != hall_layout<WIDTH, DEPTH>::size())
+		throw std::runtime_error("lie_deviation_from_file: the file holds a different algebra");
+	auto stored = [&](auto f) {
+		for (size_t i = 0; i < view.count(); ++i)
+			f(typename LIE::KEY(view.index(i) + 1), view.value(i));
+	};
+	auto in_file = [&](const typename LIE::KEY& key) {
+		double value;
+		return view.find(uint64_t(key) - 1, value);
+	};
+	return golden_files_detail::by_stored_walk(logsig, stored, in_file);
+}
+
+/// CHECKs that sig is within tolerance (maximum deviation) of the raw golden file at filepath
+template <typename SPARSEVECTOR_T, typename PATH_T>
+void CHECK_compare_with_file_close(const SPARSEVECTOR_T& sig, const PATH_T& filepath, double tolerance)
+{
+	const file_deviation deviation = deviation_from_file(sig, filepath);
+	CHECK_CLOSE(0., deviation.max, tolerance);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <crtdbg.h>  //_ASSERT
+
+// group-like tensors and their inverses
+//
+// for a group-like element g (a signature, or the exp of a lie element) the inverse is the antipode:
+// reverse every word and change the sign of the odd degrees. libalgebra provides this as reflect(),
+// which is O(size of g) and forms no products, whereas inverse() runs the general power series.
+//
+// define GROUP_LIKE_CHECK to verify group-likeness whenever a group_like is built from a TENSOR;
+// it is on by default in debug builds
+
+#if defined(_DEBUG) && !defined(GROUP_LIKE_CHECK)
+#define GROUP_LIKE_CHECK
+#endif
+
+/// the L1 norm of g * reflect(g) - 1; zero, up to rounding, exactly when g is group-like
+template <typename TENSOR>
+typename TENSOR::SCALAR group_like_defect(const TENSOR& g)
+{
+	typedef typename TENSOR::SCALAR S;
+	return (g * reflect(g) - TENSOR(S(1))).NormL1();
+}
+
+/// true if g is group-like to within a tolerance relative to the L1 norm of g (zero demands exactness)
+template <typename TENSOR>
+bool is_group_like(const TENSOR& g, double tolerance = 1.0e-10)
+{
+	typedef typename TENSOR::SCALAR S;
+	const S norm = g.NormL1();
+	return group_like_defect(g) <= S(tolerance) * ((norm > S(1)) ? norm : S(1));
+}
+
+/// the inverse of a group-like element by the antipode, in O(size) with no products
+template <typename TENSOR>
+TENSOR group_inverse(const TENSOR& g)
+{
+#ifdef GROUP_LIKE_CHECK
+	_ASSERT(is_group_like(g));
+#endif
+	return reflect(g);
+}
+
+/// group_like - a TENSOR known to be group-like, so that inverse() is the antipode
+///
+/// products of group-like elements are group-like, so code written against group_like
+/// (e.g. increments of signatures between observation times) inverts by the antipode automatically
+template <typename TENSOR>
+class group_like : public TENSOR
+{
+	struct trusted {};
+	group_like(const TENSOR& arg, trusted) : TENSOR(arg) {}
+
+public:
+	typedef typename TENSOR::SCALAR SCALAR;
+
+	// the unit
+	group_like() : TENSOR(SCALAR(1)) {}
+
+	// the caller asserts arg is group-like (checked when GROUP_LIKE_CHECK is defined)
+	explicit group_like(const TENSOR& arg) : TENSOR(arg)
+	{
+#ifdef GROUP_LIKE_CHECK
+		_ASSERT(is_group_like(arg));
+#endif
+	}
+
+	/// exp(x) for the tensor expansion x of a lie element, group-like by construction and so never checked
+	static group_like exponential(const TENSOR& x)
+	{
+		return group_like(exp(x), trusted());
+	}
+
+	friend group_like inverse(const group_like& arg)
+	{
+		return group_like(reflect(static_cast<const TENSOR&>(arg)), trusted());
+	}
+
+	friend group_like operator*(const group_like& lhs, const group_like& rhs)
+	{
+		return group_like(static_cast<const TENSOR&>(lhs) * static_cast<const TENSOR&>(rhs), trusted());
+	}
+
+	group_like& operator*=(const group_like& rhs)
+	{
+		static_cast<TENSOR&>(*this) *= static_cast<const TENSOR&>(rhs);
+		return *this;
+	}
+};
+
+/// the signature over [s, t] from the signatures over [0, s] and [0, t]
+template <typename TENSOR>
+group_like<TENSOR> signature_increment(const group_like<TENSOR>& sig_s, const group_like<TENSOR>& sig_t)
+{
+	return inverse(sig_s) * sig_t;
+}
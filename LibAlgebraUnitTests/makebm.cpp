@@ -1,12 +1,21 @@
 #include "makebm.h"
 #include <vector>
 #include <random>
+#include <cmath>
+#include <algorithm>
+#include <stddef.h> //ptrdiff_t
+
+static const unsigned int makebm_seed = (const unsigned int&)0x6d35f0e5b8f6c603;//std::random_device seed; unsigned int seed = seed();
 
 void makebm(std::vector<double>& pathi, const size_t steps, const size_t width)
+{
+	makebm(pathi, steps, width, makebm_seed);
+}
+
+void makebm(std::vector<double>& pathi, const size_t steps, const size_t width, unsigned int seed)
 {
 
 	// set up random number generation
-	unsigned int seed = (const unsigned int&)0x6d35f0e5b8f6c603;//std::random_device seed; unsigned int seed = seed();
 	std::mt19937 generator;
 	generator.seed(seed);
 	std::normal_distribution<double> distribution(0., 1. / sqrt(steps));//distribution(mean, std deviation)
@@ -21,4 +30,74 @@ void makebm(std::vector<double>& pathi, const size_t steps, const size_t width)
 
 	// return it
 	pathi.swap(path);
-}
\ No newline at end of file
+}
+
+void makebm_batch(std::vector<double>& increments, const size_t steps, const size_t width, const size_t batch)
+{
+	std::vector<double> ans(steps * width * batch), path;
+	for (size_t p = 0; p < batch; ++p) {
+		makebm(path, steps, width, makebm_seed + unsigned(p));
+		for (size_t i = 0; i < steps; ++i)
+			for (size_t j = 0; j < width; ++j)
+				ans[(i * width + j) * batch + p] = path[(i + 1) * width + j] - path[i * width + j];
+	}
+
+	// return it
+	increments.swap(ans);
+}
+
+void makebm_increments_serial(double* out, const size_t first, const size_t count, const size_t steps, const size_t width, philox_seed seed)
+{
+	const double scale = 1. / std::sqrt(double(steps));
+	const uint64_t base = uint64_t(first) * width;
+	for (size_t k = 0; k < count * width; ++k)
+		out[k] = philox_normal(seed, base + uint64_t(k)) * scale;
+}
+
+void makebm_increments(double* out, const size_t first, const size_t count, const size_t steps, const size_t width, philox_seed seed)
+{
+	// blocks of steps, each made by the serial kernel
+	const size_t block = size_t(1) << 12;
+	const ptrdiff_t blocks = ptrdiff_t((count + block - 1) / block);
+#pragma omp parallel for
+	for (ptrdiff_t b = 0; b < blocks; ++b) {
+		const size_t offset = size_t(b) * block;
+		makebm_increments_serial(out + offset * width, first + offset, std::min(block, count - offset), steps, width, seed);
+	}
+}
+
+void makebm(std::vector<double>& pathi, const size_t steps, const size_t width, philox_seed seed)
+{
+	// the block size, and so the order of the additions, does not depend on the number of threads
+	const size_t block = size_t(1) << 14;
+	const ptrdiff_t blocks = ptrdiff_t((steps + block - 1) / block);
+
+	// the increments, summed from zero within each block
+	std::vector<double> path((steps + 1) * width, 0.);
+#pragma omp parallel for
+	for (ptrdiff_t b = 0; b < blocks; ++b) {
+		const size_t first = size_t(b) * block, count = std::min(block, steps - first);
+		double* row = &path[(first + 1) * width];
+		makebm_increments_serial(row, first, count, steps, width, seed);
+		for (size_t i = 1; i < count; ++i)
+			for (size_t j = 0; j < width; ++j)
+				row[i * width + j] += row[(i - 1) * width + j];
+	}
+
+	// the start of each block, then shift the blocks
+	std::vector<double> carry(size_t(blocks) * width, 0.);
+	for (ptrdiff_t b = 1; b < blocks; ++b)
+		for (size_t j = 0; j < width; ++j)
+			carry[size_t(b) * width + j] = carry[size_t(b - 1) * width + j] + path[size_t(b) * block * width + j];
+#pragma omp parallel for
+	for (ptrdiff_t b = 1; b < blocks; ++b) {
+		const size_t first = size_t(b) * block, count = std::min(block, steps - first);
+		double* row = &path[(first + 1) * width];
+		for (size_t i = 0; i < count; ++i)
+			for (size_t j = 0; j < width; ++j)
+				row[i * width + j] += carry[size_t(b) * width + j];
+	}
+
+	// return it
+	pathi.swap(path);
+}
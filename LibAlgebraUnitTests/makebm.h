@@ -1,7 +1,26 @@
 #pragma once
 #include <vector>
+#include "philox.h"
 
 
 void makebm(std::vector<double>& pathi, const size_t steps, const size_t width);
 
+/// as makebm, from a given seed of the std::mt19937 generator
+void makebm(std::vector<double>& pathi, const size_t steps, const size_t width, unsigned int seed);
 
+/// the increments of batch brownian paths, path p made by makebm from seed + p so that path 0 is the makebm path;
+/// structure of arrays: the increment of letter j of path p over step i is increments[(i * width + j) * batch + p]
+void makebm_batch(std::vector<double>& increments, const size_t steps, const size_t width, const size_t batch);
+
+/// the increments of steps first..first + count of the counter based brownian path of the seed:
+/// the increment of letter j over step i is out[(i - first) * width + j] = philox_normal(seed, i * width + j) / sqrt(steps).
+/// Any range is made independently of the others and is bit identical to that slice of the whole.
+/// Serial, for callers that are already parallel (one range or one path per thread).
+void makebm_increments_serial(double* out, const size_t first, const size_t count, const size_t steps, const size_t width, philox_seed seed);
+
+/// as makebm_increments_serial, with the range shared among the threads
+void makebm_increments(double* out, const size_t first, const size_t count, const size_t steps, const size_t width, philox_seed seed);
+
+/// as makebm, from the counter based increments of the seed; made in parallel and bit identical whatever the
+/// number of threads, the prefix sums being taken over blocks of fixed size
+void makebm(std::vector<double>& pathi, const size_t steps, const size_t width, philox_seed seed);
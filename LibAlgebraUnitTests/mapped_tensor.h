@@ -0,0 +1,142 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "memfile.h"
+#include "tensor_layout.h"
+
+/// mapped_tensor - a dense truncated tensor whose levels live in memory mapped scratch files
+///
+/// each degree d is held in its own memfile "<prefix>.<d>" of WIDTH^d scalars so that the
+/// operating system can page levels in and out independently; the products below only ever
+/// touch the levels of a single degree pair at a time, streaming the right hand level contiguously,
+/// so the resident set is bounded by a few levels rather than the whole tensor.
+/// The files are removed when the mapped_tensor is destroyed.
+/// SCALAR must be a POD type (float or double).
+///
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+class mapped_tensor
+{
+public:
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+
+	// constructor - the zero tensor
+	explicit mapped_tensor(const std::string& prefix) : prefix(prefix)
+	{
+		for (unsigned d = 0; d <= DEPTH; ++d)
+			levels.emplace_back(new memfile(prefix + "." + std::to_string(d), LAYOUT::level_size(d) * sizeof(SCALAR), true));
+	}
+
+	// accessors
+	SCALAR* level(unsigned d) { return reinterpret_cast<SCALAR*>(levels[d]->begin()); }
+	const SCALAR* level(unsigned d) const { return reinterpret_cast<const SCALAR*>(levels[d]->cbegin()); }
+
+	/// sets every coefficient in degree d to zero
+	void clear(unsigned d)
+	{
+		std::fill(level(d), level(d) + LAYOUT::level_size(d), SCALAR(0));
+	}
+
+	/// replaces the content with a sparse TENSOR
+	template <typename TENSOR>
+	void assign(const TENSOR& arg)
+	{
+		for (unsigned d = 0; d <= DEPTH; ++d)
+			clear(d);
+		for (const auto& k : arg)
+			level(TENSOR::basis.degree(k.first))[LAYOUT::template index_in_level<TENSOR>(k.first)] = k.second;
+	}
+
+	/// the sparse TENSOR with the same (non zero) coefficients
+	template <typename TENSOR>
+	TENSOR to_tensor() const
+	{
+		TENSOR ans;
+		for (unsigned d = 0; d <= DEPTH; ++d) {
+			const SCALAR* l = level(d);
+			for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+				if (l[i] != SCALAR(0))
+					ans[LAYOUT::template key<TENSOR>(d, i)] = l[i];
+		}
+		return ans;
+	}
+
+	/// out = lhs * rhs truncated at DEPTH; out must not be lhs or rhs
+	/// each output level is formed from one level pair at a time
+	friend void multiply(const mapped_tensor& lhs, const mapped_tensor& rhs, mapped_tensor& out)
+	{
+		for (unsigned d = 0; d <= DEPTH; ++d) {
+			out.clear(d);
+			for (unsigned i = 0; i <= d; ++i)
+				outer_product_add(out.level(d), lhs.level(i), LAYOUT::level_size(i), rhs.level(d - i), LAYOUT::level_size(d - i));
+		}
+	}
+
+	/// out = lhs * rhs truncated at DEPTH for a sparse TENSOR rhs such as exp(maps.l2t(increment))
+	/// the rhs is never expanded to dense form; out must not be lhs
+	template <typename TENSOR>
+	friend void multiply(const mapped_tensor& lhs, const TENSOR& rhs, mapped_tensor& out)
+	{
+		for (unsigned d = 0; d <= DEPTH; ++d) {
+			out.clear(d);
+			for (const auto& k : rhs) {
+				const unsigned n = TENSOR::basis.degree(k.first);
+				if (n > d)
+					continue;
+				// the words u k.first with u of degree d - n
+				const size_t stride = LAYOUT::level_size(n);
+				const SCALAR* a = lhs.level(d - n);
+				SCALAR* o = out.level(d) + LAYOUT::template index_in_level<TENSOR>(k.first);
+				for (size_t i = 0; i < LAYOUT::level_size(d - n); ++i)
+					o[i * stride] += a[i] * k.second;
+			}
+		}
+	}
+
+	/// this = this * rhs truncated at DEPTH, in place from the top degree down
+	/// so no output tensor is needed unless rhs is this, when it is first copied to "<prefix>.copy"
+	mapped_tensor& operator*=(const mapped_tensor& rhs)
+	{
+		if (&rhs == this) {
+			mapped_tensor copy(prefix + ".copy");
+			for (unsigned d = 0; d <= DEPTH; ++d)
+				std::copy(level(d), level(d) + LAYOUT::level_size(d), copy.level(d));
+			multiply_inplace<WIDTH, DEPTH>(*this, copy);
+		}
+		else
+			multiply_inplace<WIDTH, DEPTH>(*this, rhs);
+		return *this;
+	}
+
+	/// this = this * rhs truncated at DEPTH, in place, for a sparse TENSOR rhs
+	template <typename TENSOR>
+	mapped_tensor& operator*=(const TENSOR& rhs)
+	{
+		multiply_inplace_sparse<WIDTH, DEPTH>(*this, rhs);
+		return *this;
+	}
+
+	/// exchanges the storage of two tensors
+	void swap(mapped_tensor& rhs)
+	{
+		levels.swap(rhs.levels);
+		prefix.swap(rhs.prefix);
+	}
+
+private:
+	std::string prefix;
+	std::vector<std::unique_ptr<memfile>> levels;
+};
+
+/// computes the signature of an iterable sequence of lie elements into a mapped_tensor
+/// the product is formed in place so only one mapped tensor and one sparse increment are ever live
+template<typename ITERATOR_T, typename FRAMEWORK, typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+void mapped_signature(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context, mapped_tensor<SCALAR, WIDTH, DEPTH>& signature)
+{
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::S S;
+	signature.assign(TENSOR(S(1)));
+	for (ITERATOR_T i = begin; i != end; i++)
+		signature *= exp(context.maps.l2t(*i));
+}
@@ -25,11 +25,14 @@ size_t memfile::size() const
 	return e - b;
 }
 
-memfile::memfile(boost::filesystem::path filename, size_t numberOfBytes /*= 0*/) : p(filename), readonly(false)
+memfile::memfile(boost::filesystem::path filename, size_t numberOfBytes /*= 0*/, bool scratch /*= false*/) : p(filename), scratch(scratch), readonly(false)
 {
 	// populate file if it does not already exist
 	boost::filesystem::path p(filename.c_str());
 	int count = 10;
+	// scratch files are never reused
+	if (scratch && boost::filesystem::exists(p))
+		boost::filesystem::remove(p);
 	if (boost::filesystem::exists(p))
 		read_only(true);
 	else
@@ -61,6 +64,8 @@ memfile::memfile(boost::filesystem::path filename, size_t numberOfBytes /*= 0*/)
 memfile::~memfile()
 {
 	file.close();
+	if (scratch)
+		boost::filesystem::remove(p);
 }
 
 bool memfile::read_only(bool val)
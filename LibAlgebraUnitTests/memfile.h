@@ -20,10 +20,13 @@ public:
 	size_t size() const;
 
 	// constructor
-	memfile(boost::filesystem::path filename, size_t numberOfBytes = 0);
+	// a scratch memfile always creates a fresh read write file of numberOfBytes zeros 
+	// and removes it on destruction
+	memfile(boost::filesystem::path filename, size_t numberOfBytes = 0, bool scratch = false);
 	~memfile();
 private:
 	boost::filesystem::path const p;
+	bool const scratch;
 	boost::iostreams::mapped_file_sink file;
 	char* b;
 	char* e;
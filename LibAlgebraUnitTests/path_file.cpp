@@ -0,0 +1,97 @@
+#include "path_file.h"
+#include <boost/filesystem/fstream.hpp>
+#include <stdexcept>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> // PrefetchVirtualMemory
+#else
+#include <sys/mman.h> // posix_madvise
+#endif
+
+namespace {
+	const char path_file_magic[8] = { 'L', 'A', 'P', 'A', 'T', 'H', 0, 0 };
+	// points start on a 64 byte boundary
+	const uint64_t path_file_data_offset = 64;
+
+	// advises the system that [begin, begin + size) will be read once, sequentially and soon
+	void advise_read_ahead(const char* begin, size_t size)
+	{
+#ifdef _WIN32
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = const_cast<char*>(begin);
+		range.NumberOfBytes = size;
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+		posix_madvise(const_cast<char*>(begin), size, POSIX_MADV_SEQUENTIAL);
+		posix_madvise(const_cast<char*>(begin), size, POSIX_MADV_WILLNEED);
+#endif
+	}
+}
+
+void write_path_file(boost::filesystem::path filename, const double* path, size_t steps, size_t width)
+{
+	path_file_header h;
+	std::memcpy(h.magic, path_file_magic, sizeof(h.magic));
+	h.version = path_file::VERSION;
+	h.dtype = sizeof(double);
+	h.width = width;
+	h.steps = steps;
+	h.data_offset = path_file_data_offset;
+	char padding[path_file_data_offset - sizeof(path_file_header)] = {};
+
+	boost::filesystem::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	file.write((const char*)&h, sizeof(h));
+	file.write(padding, sizeof(padding));
+	file.write((const char*)path, (steps + 1) * width * sizeof(double));
+	if (!file)
+		throw std::runtime_error("write_path_file: cannot write " + filename.string());
+}
+
+path_file::path_file(boost::filesystem::path filename, bool read_ahead /*= true*/) : p(filename), read_ahead(read_ahead)
+{
+	boost::filesystem::ifstream file(p, std::ios::binary);
+	file.read((char*)&h, sizeof(h));
+	if (!file || std::memcmp(h.magic, path_file_magic, sizeof(h.magic)) != 0)
+		throw std::runtime_error("path_file: not a path file " + p.string());
+	if (h.version != VERSION || h.dtype != sizeof(double) || h.data_offset % sizeof(double) != 0)
+		throw std::runtime_error("path_file: unsupported version or dtype in " + p.string());
+}
+
+const path_file_header& path_file::header() const
+{
+	return h;
+}
+
+size_t path_file::width() const
+{
+	return size_t(h.width);
+}
+
+size_t path_file::steps() const
+{
+	return size_t(h.steps);
+}
+
+size_t path_file::points() const
+{
+	return size_t(h.steps) + 1;
+}
+
+const double* path_file::window(size_t first, size_t count)
+{
+	if (count == 0 || first + count > points())
+		throw std::out_of_range("path_file: window outside the path in " + p.string());
+	const size_t row = width() * sizeof(double);
+	const size_t begin = size_t(h.data_offset) + first * row;
+	const size_t aligned = begin - begin % boost::iostreams::mapped_file::alignment();
+	const size_t length = begin + count * row - aligned;
+	if (file.is_open())
+		file.close();
+	file.open(p.string(), length, boost::iostreams::stream_offset(aligned));
+	if (!file.is_open())
+		throw std::runtime_error("path_file: cannot map " + p.string());
+	if (read_ahead)
+		advise_read_ahead(file.data(), file.size());
+	return (const double*)(file.data() + (begin - aligned));
+}
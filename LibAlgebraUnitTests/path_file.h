@@ -0,0 +1,53 @@
+#pragma once
+// boost dependencies
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem/path.hpp>
+#include <stdint.h>
+#include <stddef.h> //size_t
+
+/// the header at the start of a path file; the (steps + 1) x width row major points follow at data_offset
+///
+/// a path file holds a path exactly as makebm lays it out in memory, so that paths far larger than RAM
+/// can be read through a sliding memory mapped window without copying them into a std::vector<double>
+struct path_file_header
+{
+	char magic[8];			// "LAPATH\0\0"
+	uint32_t version;		// path_file::VERSION
+	uint32_t dtype;			// bytes per coordinate; 8 for double, the only type supported
+	uint64_t width;			// coordinates per point
+	uint64_t steps;			// increments, so steps + 1 points
+	uint64_t data_offset;	// bytes from the start of the file to the first point
+};
+
+/// writes the (steps + 1) x width row major points at path to filename as a path file
+void write_path_file(boost::filesystem::path filename, const double* path, size_t steps, size_t width);
+
+/// path_file - a read only path file mapped a window of points at a time
+///
+/// window(first, count) maps the points [first, first + count) (the mapping starts at an offset
+/// aligned as the operating system requires) and, with read_ahead, advises the system that the
+/// window will be read once, sequentially and soon. At most one window is mapped at any time.
+struct path_file
+{
+public:
+	static const uint32_t VERSION = 1;
+
+	// constructor
+	// throws std::runtime_error if the file is not a path file of doubles
+	explicit path_file(boost::filesystem::path filename, bool read_ahead = true);
+
+	// accessors
+	const path_file_header& header() const;
+	size_t width() const;
+	size_t steps() const;
+	size_t points() const;
+
+	/// the points [first, first + count) as count rows of width doubles; valid until the next call
+	const double* window(size_t first, size_t count);
+
+private:
+	boost::filesystem::path const p;
+	bool const read_ahead;
+	path_file_header h;
+	boost::iostreams::mapped_file_source file;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <stddef.h> //size_t
+
+/// path_trie - a forest of paths sharing their common prefixes
+///
+/// node 0 is the empty path; every other node is its parent extended by one increment, so a path
+/// of n increments ends at a node of depth n and paths with a common prefix share its nodes.
+/// Increments are matched by equality, as for paths branched from a common scenario.
+template <typename LIE>
+class path_trie
+{
+public:
+	static const size_t root = 0;
+
+	// constructor
+	path_trie() : parents(1, root), steps(1, LIE()), depths(1, 0), children(1), total(0) {}
+
+	/// adds the path of increments [begin, end) and returns the node at which it ends
+	template <typename ITERATOR_T>
+	size_t insert(ITERATOR_T begin, ITERATOR_T end)
+	{
+		size_t node = root;
+		for (ITERATOR_T i = begin; i != end; ++i, ++total) {
+			size_t next = root;
+			for (const size_t c : children[node])
+				if (steps[c] == *i) {
+					next = c;
+					break;
+				}
+			if (next == root) {
+				next = parents.size();
+				parents.push_back(node);
+				steps.push_back(*i);
+				depths.push_back(depths[node] + 1);
+				children.emplace_back();
+				children[node].push_back(next);
+			}
+			node = next;
+		}
+		ends.push_back(node);
+		return node;
+	}
+
+	// the nodes
+	size_t size() const { return parents.size(); }
+	size_t parent(size_t node) const { return parents[node]; }
+	const LIE& increment(size_t node) const { return steps[node]; }
+	size_t depth(size_t node) const { return depths[node]; }
+	const std::vector<size_t>& successors(size_t node) const { return children[node]; }
+
+	// the paths, in the order inserted
+	const std::vector<size_t>& path_ends() const { return ends; }
+
+	/// the number of increments over all the paths, against size() - 1 distinct ones
+	size_t total_increments() const { return total; }
+
+private:
+	std::vector<size_t> parents;
+	std::vector<LIE> steps;
+	std::vector<size_t> depths;
+	std::vector<std::vector<size_t>> children;
+	std::vector<size_t> ends;
+	size_t total;
+};
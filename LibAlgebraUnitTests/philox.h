@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h> //size_t
+#include <cmath>
+
+// Philox4x32-10, the counter based random number generator of Salmon et al. (Random123)
+//
+// the output is a pure function of a 128 bit counter and a 64 bit key, so the random numbers for
+// any index can be made independently: a path generated in parallel, in any order or over any
+// split of the steps, is bit identical to the path generated sequentially.
+
+/// a seed for the counter based generators, distinct from the std::mt19937 seeds
+struct philox_seed
+{
+	uint64_t value;
+};
+
+/// the four 32 bit words of Philox4x32-10 at counter (c0, c1, c2, c3) under the key
+inline void philox4x32(uint32_t out[4], uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint64_t key)
+{
+	uint32_t k0 = uint32_t(key), k1 = uint32_t(key >> 32);
+	for (unsigned round = 0; round < 10; ++round) {
+		const uint64_t p0 = uint64_t(0xD2511F53) * c0;
+		const uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+		const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+		const uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+		c0 = n0;
+		c1 = uint32_t(p1);
+		c2 = n2;
+		c3 = uint32_t(p0);
+		k0 += 0x9E3779B9;
+		k1 += 0xBB67AE85;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+/// the index-th standard normal of the stream: Box-Muller on the two 64 bit uniforms of counter index / 2
+inline double philox_normal(philox_seed seed, uint64_t index)
+{
+	uint32_t w[4];
+	philox4x32(w, uint32_t(index >> 1), uint32_t(index >> 33), 0x6e6f726d /*norm*/, 0, seed.value);
+	// uniforms in (0, 1] and [0, 1) from the top 53 bits of each pair of words
+	const double u1 = (double((((uint64_t)w[0] << 32) | w[1]) >> 11) + 1.) * (1. / 9007199254740992.);
+	const double u2 = double((((uint64_t)w[2] << 32) | w[3]) >> 11) * (1. / 9007199254740992.);
+	const double r = std::sqrt(-2. * std::log(u1));
+	const double theta = 6.283185307179586476925286766559 * u2;
+	return (index & 1) ? r * std::sin(theta) : r * std::cos(theta);
+}
+
+/// the index-th letter of a uniform stream over 1..width
+inline size_t philox_letter(philox_seed seed, uint64_t index, size_t width)
+{
+	uint32_t w[4];
+	philox4x32(w, uint32_t(index), uint32_t(index >> 32), 0x63617467 /*catg*/, 0, seed.value);
+	// a 64 bit draw reduced modulo width; the bias is below width / 2^64
+	return 1 + size_t((((uint64_t)w[0] << 32) | w[1]) % width);
+}
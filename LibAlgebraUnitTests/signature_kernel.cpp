@@ -0,0 +1,121 @@
+#include "signature_kernel.h"
+
+namespace {
+	// <x_i, y_j> for rows of width doubles
+	double inner_product(const double* x, const double* y, size_t width)
+	{
+		double sum = 0.;
+		for (size_t k = 0; k < width; ++k)
+			sum += x[k] * y[k];
+		return sum;
+	}
+}
+
+truncated_signature_kernel::truncated_signature_kernel(size_t width, unsigned depth) : width(width), depth(depth)
+{
+}
+
+double truncated_signature_kernel::operator()(const double* x, size_t n, const double* y, size_t m)
+{
+	level.assign(depth + 1, 0.);
+	level[0] = 1.;
+	if (n == 0 || m == 0 || depth == 0)
+		return 1.;
+	const size_t D = depth;
+	// P_L(i, j, r, s), the sums over L letters ending at the pair (i, j) with runs r + 1 and s + 1, at
+	// cell[((L - 1) * D + r) * D + s]; P_(L+1)(i, j) reads P_L(i, j) and the sums below of the cells before
+	// (i, j), so the cells are swept row by row keeping only those sums:
+	// rows(j, L, s) = sum over i' < i and r of P_L(i', j, r, s), a new letter starting a run in i
+	// columns(L, r) = sum over j' < j and s of P_L(i, j', r, s), a new letter starting a run in j
+	// totals(L) = sum over i' < i, j' < j, r and s of P_L(i', j', r, s), starting runs in both
+	cell.assign(D * D * D, 0.);
+	rows.assign(m * D * D, 0.);
+	columns.assign(D * D, 0.);
+	totals.assign(D, 0.);
+
+	for (size_t i = 0; i < n; ++i) {
+		std::fill(columns.begin(), columns.end(), 0.);
+		std::fill(totals.begin(), totals.end(), 0.);
+		for (size_t j = 0; j < m; ++j) {
+			const double c = inner_product(x + i * width, y + j * width, width);
+			double* above = &rows[j * D * D];
+
+			// one letter: a run of length one in each
+			cell[0] = c;
+			level[1] += c;
+			for (size_t l = 1; l < D; ++l) {
+				const double* p = &cell[(l - 1) * D * D];
+				double* o = &cell[l * D * D];
+				const double* a = &above[(l - 1) * D];
+				const double* b = &columns[(l - 1) * D];
+				o[0] = c * totals[l - 1];
+				for (size_t s = 1; s <= l; ++s)
+					o[s] = c * a[s - 1] / double(s + 1);
+				double sum = o[0];
+				for (size_t s = 1; s <= l; ++s)
+					sum += o[s];
+				for (size_t r = 1; r <= l; ++r) {
+					o[r * D] = c * b[r - 1] / double(r + 1);
+					sum += o[r * D];
+					for (size_t s = 1; s <= l; ++s) {
+						o[r * D + s] = c * p[(r - 1) * D + s - 1] / double((r + 1) * (s + 1));
+						sum += o[r * D + s];
+					}
+				}
+				level[l + 1] += sum;
+			}
+
+			// fold (i, j) into the sums for the cells after it; totals first, from the rows above alone
+			for (size_t l = 0; l < D; ++l) {
+				const double* p = &cell[l * D * D];
+				double* a = &above[l * D];
+				double* b = &columns[l * D];
+				for (size_t s = 0; s <= l; ++s)
+					totals[l] += a[s];
+				for (size_t r = 0; r <= l; ++r)
+					for (size_t s = 0; s <= l; ++s) {
+						a[s] += p[r * D + s];
+						b[r] += p[r * D + s];
+					}
+			}
+		}
+	}
+
+	double ans = 0.;
+	for (const double v : level)
+		ans += v;
+	return ans;
+}
+
+const std::vector<double>& truncated_signature_kernel::levels() const
+{
+	return level;
+}
+
+pde_signature_kernel::pde_signature_kernel(size_t width, unsigned refinement) : width(width), refinement(refinement)
+{
+}
+
+double pde_signature_kernel::operator()(const double* x, size_t n, const double* y, size_t m)
+{
+	const size_t cells = size_t(1) << refinement;
+	const size_t columns = m * cells + 1;
+	previous.assign(columns, 1.);
+	row.assign(columns, 1.);
+	const double scale = 1. / double(cells * cells);
+	for (size_t i = 0; i < n; ++i)
+		for (size_t a = 0; a < cells; ++a) {
+			row[0] = 1.;
+			for (size_t j = 0; j < m; ++j) {
+				double inc = 0.;
+				for (size_t k = 0; k < width; ++k)
+					inc += x[i * width + k] * y[j * width + k];
+				inc *= scale;
+				const double c1 = 1. + inc / 2. + inc * inc / 12., c0 = 1. - inc * inc / 12.;
+				for (size_t b = j * cells; b < (j + 1) * cells; ++b)
+					row[b + 1] = (row[b] + previous[b + 1]) * c1 - previous[b] * c0;
+			}
+			previous.swap(row);
+		}
+	return previous.back();
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <stddef.h> //size_t
+
+// signature kernels: <S(x), S(y)> for two paths given by their increments, computed from the matrix
+// of inner products <dx_i, dy_j> of the increments alone, so no signature is ever formed.
+// A path of n increments is n rows of width doubles (the makebm_increments layout).
+
+/// truncated_signature_kernel - the exact inner product of the signatures of two piecewise linear paths
+/// truncated at depth
+///
+/// the level k part sum_w S_w(x) S_w(y) is a sum over the non decreasing k-tuples (i_l) and (j_l) of
+/// prod_l <dx_i_l, dy_j_l> divided by the factorials of the lengths of the runs of repeated indices;
+/// it is built one letter at a time by dynamic programming over the last pair (i, j) and the lengths
+/// of the current runs, at a cost of O(n m depth^3). The pairs are swept row by row holding the states
+/// of one pair and running sums over the pairs before it, so the scratch is O(m depth^2 + depth^3) doubles
+/// whatever n; it is reused between calls, so a copy is needed per thread.
+class truncated_signature_kernel
+{
+public:
+	// constructor
+	truncated_signature_kernel(size_t width, unsigned depth);
+
+	/// <S(x), S(y)> truncated at depth for the paths of n and m increments x and y
+	double operator()(const double* x, size_t n, const double* y, size_t m);
+
+	/// the level k parts, levels[0] = 1, of the last call
+	const std::vector<double>& levels() const;
+
+private:
+	size_t const width;
+	unsigned const depth;
+	std::vector<double> cell;		// P_L(i, j, r, s) of one pair (i, j), L letters and runs r, s in 1..depth
+	std::vector<double> rows;		// sums over the pairs before (i, j) used by the transitions
+	std::vector<double> columns;
+	std::vector<double> totals;
+	std::vector<double> level;
+};
+
+/// pde_signature_kernel - the untruncated signature kernel as the solution of the Goursat problem
+/// d^2 k / ds dt = <x'(s), y'(t)> k, k(0, .) = k(., 0) = 1
+///
+/// each cell of the grid of increments is refined 2^refinement times in each direction and the second
+/// order explicit scheme of Salvi et al. (2021) is used; the error falls by about 4 for each refinement.
+/// The scratch is reused between calls, so a copy is needed per thread.
+class pde_signature_kernel
+{
+public:
+	// constructor
+	pde_signature_kernel(size_t width, unsigned refinement);
+
+	/// <S(x), S(y)> for the paths of n and m increments x and y
+	double operator()(const double* x, size_t n, const double* y, size_t m);
+
+private:
+	size_t const width;
+	unsigned const refinement;
+	std::vector<double> previous;	// one row of the grid
+	std::vector<double> row;
+};
+
+/// the N x N gram matrix gram[p * N + q] = kernel(path p, path q) of N paths of steps increments of width
+/// doubles, path p at paths + p * steps * width. Only the tiles on and above the diagonal are computed,
+/// each once, and mirrored; the tiles are shared dynamically among the threads, each with its own copy of
+/// the kernel and so of its scratch. Throws std::invalid_argument if tile is 0.
+template <typename KERNEL>
+void signature_gram(const double* paths, size_t N, size_t steps, size_t width, const KERNEL& kernel
+	, std::vector<double>& gram, size_t tile = 16)
+{
+	if (tile == 0)
+		throw std::invalid_argument("signature_gram: the tile size is 0");
+	gram.assign(N * N, 0.);
+	const size_t tiles = (N + tile - 1) / tile;
+	std::vector<std::pair<size_t, size_t>> pairs;
+	for (size_t a = 0; a < tiles; ++a)
+		for (size_t b = a; b < tiles; ++b)
+			pairs.emplace_back(a, b);
+	const ptrdiff_t T = ptrdiff_t(pairs.size());
+	const size_t length = steps * width;
+#pragma omp parallel
+	{
+		KERNEL k(kernel);
+#pragma omp for schedule(dynamic)
+		for (ptrdiff_t t = 0; t < T; ++t) {
+			const size_t a = pairs[size_t(t)].first, b = pairs[size_t(t)].second;
+			for (size_t p = a * tile; p < std::min(N, (a + 1) * tile); ++p)
+				for (size_t q = std::max(p, b * tile); q < std::min(N, (b + 1) * tile); ++q)
+					gram[p * N + q] = gram[q * N + p] = k(paths + p * length, steps, paths + q * length, steps);
+		}
+	}
+}
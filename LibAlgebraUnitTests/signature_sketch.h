@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <cmath>
+#include <stddef.h> //size_t
+
+/// signature_sketch - a fixed, reproducible set of random linear functionals of a truncated signature
+///
+/// projection r at level n is the rank one functional S -> <u(r,1) (x) ... (x) u(r,n), S_n> where the
+/// u(r,k) in R^WIDTH have independent N(0, 1/WIDTH) entries drawn from a std::mt19937 seeded with seed.
+/// Because the functionals are rank one, Chen's identity S -> S exp(x) acts on the DEPTH + 1 prefix
+/// values p(r,n) = <u(r,1) (x) ... (x) u(r,n), S_n> of each projection by
+///     p(r,n) <- sum_i p(r,i) <u(r,i+1),x> ... <u(r,n),x> / (n-i)!
+/// so a whole path is sketched in O(projections DEPTH^2) per step without ever forming the tensor.
+///
+template <unsigned WIDTH, unsigned DEPTH>
+class signature_sketch
+{
+public:
+	// constructor
+	signature_sketch(size_t projections, unsigned int seed = (const unsigned int&)0x6d35f0e5b8f6c603)
+		: projections(projections), u(projections * DEPTH * WIDTH)
+	{
+		std::mt19937 generator;
+		generator.seed(seed);
+		std::normal_distribution<double> distribution(0., 1. / std::sqrt(double(WIDTH)));
+		for (double& x : u)
+			x = distribution(generator);
+		inverse_factorial[0] = 1.;
+		for (unsigned n = 1; n <= DEPTH; ++n)
+			inverse_factorial[n] = inverse_factorial[n - 1] / n;
+	}
+
+	/// the number of values in a sketch: one per projection and level 1..DEPTH
+	size_t size() const { return projections * DEPTH; }
+
+	/// the state of the recursion for the signature of the constant path
+	std::vector<double> identity() const
+	{
+		std::vector<double> state(projections * (DEPTH + 1), 0.);
+		for (size_t r = 0; r < projections; ++r)
+			state[r * (DEPTH + 1)] = 1.;
+		return state;
+	}
+
+	/// Chen's identity: state <- sketch of (signature exp(x)) for an increment x in R^WIDTH
+	void update(std::vector<double>& state, const double* x) const
+	{
+		double c[DEPTH + 1];
+		for (size_t r = 0; r < projections; ++r) {
+			double* p = &state[r * (DEPTH + 1)];
+			for (unsigned k = 1; k <= DEPTH; ++k) {
+				const double* ur = direction(r, k);
+				c[k] = 0.;
+				for (unsigned a = 0; a < WIDTH; ++a)
+					c[k] += ur[a] * x[a];
+			}
+			// top down so that p(r,i), i < n, still refer to the old signature
+			for (unsigned n = DEPTH; n >= 1; --n) {
+				double acc = p[n], prod = 1.;
+				for (unsigned i = n; i-- > 0;) {
+					prod *= c[i + 1];
+					acc += p[i] * prod * inverse_factorial[n - i];
+				}
+				p[n] = acc;
+			}
+		}
+	}
+
+	/// the sketch values (projection major, levels 1..DEPTH) held in a state
+	std::vector<double> values(const std::vector<double>& state) const
+	{
+		std::vector<double> ans(size());
+		for (size_t r = 0; r < projections; ++r)
+			for (unsigned n = 1; n <= DEPTH; ++n)
+				ans[r * DEPTH + n - 1] = state[r * (DEPTH + 1) + n];
+		return ans;
+	}
+
+	/// applies the same functionals to a full TENSOR (for checking)
+	template <typename TENSOR>
+	std::vector<double> apply(const TENSOR& arg) const
+	{
+		std::vector<double> ans(size(), 0.);
+		for (const auto& k : arg) {
+			const unsigned n = TENSOR::basis.degree(k.first);
+			if (n == 0)
+				continue;
+			for (size_t r = 0; r < projections; ++r) {
+				double prod = double(k.second);
+				unsigned j = 1;
+				for (typename TENSOR::KEY w = k.first; TENSOR::basis.degree(w) > 0; w = TENSOR::basis.rparent(w))
+					prod *= direction(r, j++)[TENSOR::basis.getfirstletter(w) - 1];
+				ans[r * DEPTH + n - 1] += prod;
+			}
+		}
+		return ans;
+	}
+
+private:
+	size_t projections;
+	std::vector<double> u;
+	double inverse_factorial[DEPTH + 1];
+
+	// u(r,k), k in 1..DEPTH
+	const double* direction(size_t r, unsigned k) const { return &u[(r * DEPTH + k - 1) * WIDTH]; }
+};
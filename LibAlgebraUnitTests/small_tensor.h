@@ -0,0 +1,189 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <type_traits>
+#include "tensor_layout.h"
+#include "dense_tensor.h"
+
+// tensors of small shape (e.g. WIDTH 2 or 3, DEPTH <= 6) held in a std::array
+//
+// every loop bound of the product is a compile time constant: unroll<N> expands the loops over
+// degrees, and the loops over the coefficients of a degree pair are left as for loops of constant
+// trip count for the compiler to vectorise, so a step of a signature of a tiny shape has no maps
+// or allocation and the instantiations grow with DEPTH^2 rather than with the coefficient pairs.
+// fast_tensor<SCALAR, WIDTH, DEPTH> selects small_tensor when the shape is at most
+// SMALL_TENSOR_MAX_SIZE coefficients and dense_tensor otherwise; the two share an interface.
+
+#ifndef SMALL_TENSOR_MAX_SIZE
+#define SMALL_TENSOR_MAX_SIZE 1093 // WIDTH 3, DEPTH 6
+#endif
+
+namespace small_tensor_detail {
+
+	template <typename F, size_t... I>
+	inline void unroll(F&& f, std::index_sequence<I...>)
+	{
+		int expand[] = { 0, (f(std::integral_constant<size_t, I>()), 0)... };
+		(void)expand;
+	}
+
+} // namespace small_tensor_detail
+
+/// calls f(std::integral_constant<size_t, I>()) for I = 0..N-1, expanded at compile time
+template <size_t N, typename F>
+inline void unroll(F&& f)
+{
+	small_tensor_detail::unroll(f, std::make_index_sequence<N>());
+}
+
+/// small_tensor - a truncated tensor of small shape in a std::array, in the tensor_layout order
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+class small_tensor
+{
+public:
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	typedef std::array<SCALAR, LAYOUT::size()> STORAGE;
+
+	// constructors
+	small_tensor() { data.fill(SCALAR(0)); }
+	explicit small_tensor(const SCALAR& s) { data.fill(SCALAR(0)); data[0] = s; }
+
+	// accessors
+	SCALAR* level(unsigned d) { return &data[LAYOUT::offset(d)]; }
+	const SCALAR* level(unsigned d) const { return &data[LAYOUT::offset(d)]; }
+	SCALAR& operator[](size_t i) { return data[i]; }
+	const SCALAR& operator[](size_t i) const { return data[i]; }
+	static constexpr size_t size() { return LAYOUT::size(); }
+
+	/// replaces the content with a sparse TENSOR
+	template <typename TENSOR>
+	void assign(const TENSOR& arg)
+	{
+		data.fill(SCALAR(0));
+		for (const auto& k : arg)
+			data[LAYOUT::template index<TENSOR>(k.first)] = k.second;
+	}
+
+	/// the sparse TENSOR with the same (non zero) coefficients
+	template <typename TENSOR>
+	TENSOR to_tensor() const
+	{
+		TENSOR ans;
+		for (unsigned d = 0; d <= DEPTH; ++d) {
+			const SCALAR* l = level(d);
+			for (size_t i = 0; i < LAYOUT::level_size(d); ++i)
+				if (l[i] != SCALAR(0))
+					ans[LAYOUT::template key<TENSOR>(d, i)] = l[i];
+		}
+		return ans;
+	}
+
+	/// this = this * rhs truncated at DEPTH, in place, unrolled over the degrees
+	small_tensor& operator*=(const small_tensor& rhs)
+	{
+		if (&rhs == this) {
+			const small_tensor copy(rhs);
+			multiply(data, copy.data);
+		}
+		else
+			multiply(data, rhs.data);
+		return *this;
+	}
+
+	/// this = this * rhs truncated at DEPTH, in place, for a sparse TENSOR rhs
+	template <typename TENSOR>
+	small_tensor& operator*=(const TENSOR& rhs)
+	{
+		multiply_inplace_sparse<WIDTH, DEPTH>(*this, rhs);
+		return *this;
+	}
+
+	/// exchanges the content of two tensors
+	void swap(small_tensor& rhs)
+	{
+		data.swap(rhs.data);
+	}
+
+	friend bool operator==(const small_tensor& lhs, const small_tensor& rhs)
+	{
+		return lhs.data == rhs.data;
+	}
+
+	/// x <- exp(x) for x with no scalar part; h is scratch, kept for the dense_tensor interface
+	friend void exp_inplace(small_tensor& x, small_tensor& h)
+	{
+		// h is a polynomial in x so x h = h x, and the Horner step h <- 1 + x h / k is formed in place in h
+		h = small_tensor(SCALAR(1));
+		unroll<DEPTH>([&](auto r) {
+			const SCALAR scale = SCALAR(1) / SCALAR(DEPTH - decltype(r)::value);
+			multiply(h.data, x.data);
+			for (size_t j = 0; j < LAYOUT::size(); ++j)
+				h.data[j] *= scale;
+			h.data[0] = SCALAR(1);
+		});
+		x.swap(h);
+	}
+
+	friend small_tensor exp(const small_tensor& x)
+	{
+		small_tensor ans(x), h;
+		exp_inplace(ans, h);
+		return ans;
+	}
+
+	/// g <- log(g) for g with scalar part one; h is scratch
+	friend void log_inplace(small_tensor& g, small_tensor& h)
+	{
+		// with x = g - 1, h <- 1/k - x h for k = DEPTH - 1..1 and then log(g) = x h = h x
+		g.data[0] = SCALAR(0);
+		h = small_tensor(SCALAR(1) / SCALAR(DEPTH));
+		unroll<DEPTH - 1>([&](auto r) {
+			multiply(h.data, g.data);
+			for (size_t j = 0; j < LAYOUT::size(); ++j)
+				h.data[j] = -h.data[j];
+			h.data[0] = SCALAR(1) / SCALAR(DEPTH - 1 - decltype(r)::value);
+		});
+		multiply(h.data, g.data);
+		g.swap(h);
+	}
+
+	friend small_tensor log(const small_tensor& g)
+	{
+		small_tensor ans(g), h;
+		log_inplace(ans, h);
+		return ans;
+	}
+
+private:
+	STORAGE data;
+
+	// lhs = lhs * rhs truncated at DEPTH, top degree down as in multiply_inplace
+	static void multiply(STORAGE& lhs, const STORAGE& rhs)
+	{
+		const SCALAR unit = rhs[0];
+		unroll<DEPTH + 1>([&](auto r) {
+			const unsigned d = DEPTH - unsigned(decltype(r)::value);
+			const size_t out = LAYOUT::offset(d);
+			for (size_t j = 0; j < LAYOUT::level_size(DEPTH - decltype(r)::value); ++j)
+				lhs[out + j] *= unit;
+			unroll<DEPTH - decltype(r)::value>([&](auto i) {
+				// lhs_i (x) rhs_{d-i}
+				constexpr unsigned di = unsigned(decltype(i)::value);
+				constexpr size_t na = LAYOUT::level_size(di);
+				constexpr size_t nb = LAYOUT::level_size(DEPTH - decltype(r)::value - di);
+				const size_t a = LAYOUT::offset(di), b = LAYOUT::offset(d - di);
+				for (size_t p = 0; p < na; ++p) {
+					const SCALAR lp = lhs[a + p];
+					SCALAR* o = &lhs[out + p * nb];
+					for (size_t q = 0; q < nb; ++q)
+						o[q] += lp * rhs[b + q];
+				}
+			});
+		});
+	}
+};
+
+/// small_tensor for shapes of at most SMALL_TENSOR_MAX_SIZE coefficients, dense_tensor otherwise
+template <typename SCALAR, unsigned WIDTH, unsigned DEPTH>
+using fast_tensor = typename std::conditional<(tensor_layout<WIDTH, DEPTH>::size() <= SMALL_TENSOR_MAX_SIZE)
+	, small_tensor<SCALAR, WIDTH, DEPTH>, dense_tensor<SCALAR, WIDTH, DEPTH>>::type;
@@ -0,0 +1,238 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+#include <stddef.h> //size_t
+#include <omp.h>
+#include "tensor_layout.h"
+#include "dense_tensor.h"
+#include "feature_matrix.h" // dynkin_table
+
+/// latency_histogram - counts of durations in buckets of 1/8 of an octave of nanoseconds
+///
+/// fixed size, so recording never allocates; quantiles are the upper edges of their buckets and so
+/// overestimate by at most 1/8
+class latency_histogram
+{
+public:
+	static const unsigned SUB_BUCKETS = 8;
+
+	latency_histogram() { reset(); }
+
+	void reset()
+	{
+		counts.fill(0);
+		n = 0;
+		total = 0;
+		largest = 0;
+	}
+
+	void record(uint64_t nanoseconds)
+	{
+		++counts[bucket(nanoseconds)];
+		++n;
+		total += nanoseconds;
+		largest = std::max(largest, nanoseconds);
+	}
+
+	// accessors
+	uint64_t count() const { return n; }
+	uint64_t max() const { return largest; }
+	double mean() const { return n ? double(total) / double(n) : 0.; }
+
+	/// the latency in nanoseconds below which a fraction q of the recorded durations fall
+	uint64_t quantile(double q) const
+	{
+		const uint64_t rank = uint64_t(q * double(n));
+		uint64_t seen = 0;
+		for (size_t b = 0; b < counts.size(); ++b)
+			if ((seen += counts[b]) > rank || seen == n)
+				return std::min(upper_edge(b), largest);
+		return largest;
+	}
+
+private:
+	// durations below 8 ns have one bucket each, then each octave [2^e, 2^(e+1)) is split in eight
+	static size_t bucket(uint64_t v)
+	{
+		if (v < SUB_BUCKETS)
+			return size_t(v);
+		unsigned e = 3;
+		while ((v >> (e + 1)) != 0)
+			++e;
+		return size_t((e - 2) * SUB_BUCKETS + ((v >> (e - 3)) & (SUB_BUCKETS - 1)));
+	}
+
+	static uint64_t upper_edge(size_t b)
+	{
+		if (b < SUB_BUCKETS)
+			return uint64_t(b);
+		const unsigned e = unsigned(b / SUB_BUCKETS) + 2;
+		return ((uint64_t(SUB_BUCKETS + b % SUB_BUCKETS + 1)) << (e - 3)) - 1;
+	}
+
+	std::array<uint64_t, 62 * SUB_BUCKETS> counts;
+	uint64_t n;
+	uint64_t total;
+	uint64_t largest;
+};
+
+/// streaming_signature - the running signature of a live path, updated one degree one increment at a time
+///
+/// every buffer, including those of logsig(), is sized on construction so that push() and logsig()
+/// never allocate; each push() is timed into latency()
+template <typename FRAMEWORK>
+class streaming_signature
+{
+public:
+	typedef typename FRAMEWORK::S S;
+	typedef typename FRAMEWORK::TENSOR TENSOR;
+	typedef typename FRAMEWORK::LIE LIE;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	typedef tensor_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> LAYOUT;
+
+	// constructor
+	// the context is only used here, to tabulate t2l
+	explicit streaming_signature(const FRAMEWORK& context, bool time_updates = true)
+		: sig(S(1))
+		, table(dynkin_table(context))
+		, lie(hall_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>::size(), 0.)
+		, n(0)
+		, timed(time_updates)
+	{
+		scratch.resize(2 * ((FRAMEWORK::DEPTH > 1) ? LAYOUT::level_size(FRAMEWORK::DEPTH - 1) : 1));
+	}
+
+	/// sig <- sig * exp(x) for the increment x[0..ALPHABET_SIZE)
+	void push(const double* x)
+	{
+		if (timed) {
+			const auto start = std::chrono::steady_clock::now();
+			chen_update<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>(sig, x, scratch);
+			histogram.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+		}
+		else
+			chen_update<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>(sig, x, scratch);
+		++n;
+	}
+
+	/// restarts the path; the latency record is kept
+	void reset()
+	{
+		std::fill(&sig[0], &sig[0] + sig.size(), S(0));
+		sig[0] = S(1);
+		n = 0;
+	}
+
+	// accessors
+	size_t steps() const { return n; }
+	const DENSE& signature() const { return sig; }
+	const latency_histogram& latency() const { return histogram; }
+	latency_histogram& latency() { return histogram; }
+
+	/// the logsignature of the path so far as Hall basis coefficients (column k - 1 is Hall element k);
+	/// valid until the next call
+	const std::vector<double>& logsig()
+	{
+		std::copy(&sig[0], &sig[0] + sig.size(), &logarithm[0]);
+		log_inplace(logarithm, horner);
+		dynkin_project(table, logarithm, lie);
+		return lie;
+	}
+
+	/// the logsignature of the path so far as a LIE (allocates)
+	LIE logsignature()
+	{
+		const std::vector<double>& coefficients = logsig();
+		LIE ans;
+		for (size_t k = 0; k < coefficients.size(); ++k)
+			if (coefficients[k] != 0.)
+				ans += LIE(typename LIE::KEY(k + 1), S(coefficients[k]));
+		return ans;
+	}
+
+private:
+	DENSE sig;
+	DENSE logarithm;
+	DENSE horner;
+	std::vector<S> scratch;
+	const std::vector<std::vector<std::pair<size_t, double>>> table;
+	std::vector<double> lie;
+	size_t n;
+	const bool timed;
+	latency_histogram histogram;
+};
+
+/// the number of logsignature rows prefix_logsignatures makes for the prefixes every, 2 every, .. <= steps
+inline size_t prefix_count(size_t steps, size_t every)
+{
+	return every ? steps / every : 0;
+}
+
+/// writes the logsignatures of the prefixes of lengths every, 2 every, .. of a path to consecutive rows of
+/// out, each of LIE::basis.size() T (column k - 1 is Hall element k); increment i is the ALPHABET_SIZE
+/// doubles at increments + i * stride. Returns the number of rows.
+///
+/// the work reused between outputs is the signature, carried forward once along the path by Chen updates,
+/// and the dynkin_table; each output prefix then costs one dense log and projection of a copy of the
+/// signature. The copies of a batch are independent, so their logs are shared among the threads, each
+/// reusing one scratch tensor. Only batch dense tensors are alive at once, one per thread if batch is 0.
+///
+/// The log is deliberately not carried forward. log(exp(L) exp(x)) for a degree one x needs the whole
+/// truncated BCH series, and even its part linear in x, sum_k B_k / k! ad_L^k(x), is dearer than the log:
+/// every ad_L^k(x) runs up to degree DEPTH, where the k-th Horner product of log_inplace stops at
+/// DEPTH - k (3 to 4 times the time of the log at WIDTH 4, DEPTH 6 and WIDTH 2, DEPTH 10).
+template <typename FRAMEWORK, typename T>
+size_t prefix_logsignatures(const double* increments, size_t steps, size_t stride, size_t every
+	, const FRAMEWORK& context, T* out, size_t batch = 0)
+{
+	typedef typename FRAMEWORK::S S;
+	typedef dense_tensor<S, FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> DENSE;
+	const size_t rows = prefix_count(steps, every);
+	const size_t columns = hall_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>::size();
+	if (rows == 0)
+		return 0;
+	const std::vector<std::vector<std::pair<size_t, double>>> table = dynkin_table(context);
+	if (batch == 0)
+		batch = size_t(omp_get_max_threads());
+	std::vector<DENSE> copies(std::min(batch, rows));
+	DENSE sig(S(1));
+	std::vector<S> scratch;
+	size_t i = 0;
+	for (size_t row = 0; row < rows; row += copies.size()) {
+		const ptrdiff_t B = ptrdiff_t(std::min(copies.size(), rows - row));
+		for (ptrdiff_t r = 0; r < B; ++r) {
+			for (; i < (row + size_t(r) + 1) * every; ++i)
+				chen_update<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>(sig, increments + i * stride, scratch);
+			std::copy(&sig[0], &sig[0] + sig.size(), &copies[size_t(r)][0]);
+		}
+#pragma omp parallel
+		{
+			DENSE horner;
+			std::vector<double> lie(columns);
+#pragma omp for
+			for (ptrdiff_t r = 0; r < B; ++r) {
+				DENSE& logarithm = copies[size_t(r)];
+				log_inplace(logarithm, horner);
+				dynkin_project(table, logarithm, lie);
+				T* o = out + (row + size_t(r)) * columns;
+				for (size_t k = 0; k < columns; ++k)
+					o[k] = T(lie[k]);
+			}
+		}
+	}
+	return rows;
+}
+
+/// as prefix_logsignatures, into the rows first_row.. of a feature_matrix with LIE::basis.size() columns
+template <typename FRAMEWORK>
+size_t prefix_logsignatures(const double* increments, size_t steps, size_t stride, size_t every
+	, const FRAMEWORK& context, feature_matrix& matrix, size_t first_row)
+{
+	if (matrix.columns() != hall_layout<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH>::size()
+		|| first_row + prefix_count(steps, every) > matrix.rows())
+		throw std::runtime_error("prefix_logsignatures: the matrix does not fit the features");
+	return prefix_logsignatures(increments, steps, stride, every, context, matrix.row(first_row));
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include <stddef.h> //size_t
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "libalgebra/alg_types.h"
+#include "basis_dimensions.h"
+
+/// tensor_layout - the dense layout of the tensor basis truncated at DEPTH over WIDTH letters
+///
+/// words are ordered by degree and then lexicographically, as in TENSOR::basis; the words of
+/// degree d occupy [offset(d), offset(d) + level_size(d)) and the word (a_1,...,a_d) with letters
+/// in 1..WIDTH sits at offset(d) + (a_1 - 1) WIDTH^(d-1) + ... + (a_d - 1) within the buffer.
+/// So the concatenation uv of words of degree m and n sits at index_in_level(u) WIDTH^n + index_in_level(v)
+/// within level m + n.
+///
+template <unsigned WIDTH, unsigned DEPTH>
+struct tensor_layout
+{
+	/// the number of words of degree d
+	static constexpr size_t level_size(unsigned d)
+	{
+		return offsets[d + 1] - offsets[d];
+	}
+
+	/// the index of the empty word of degree d
+	static constexpr size_t offset(unsigned d)
+	{
+		return offsets[d];
+	}
+
+	/// the dimension of the truncated tensor algebra
+	static constexpr size_t size()
+	{
+		return offsets[DEPTH + 1];
+	}
+
+	/// the position within its level of the word with letters letters[0..d) in 1..WIDTH
+	static constexpr size_t word_index(const alg::LET* letters, unsigned d)
+	{
+		size_t ans = 0;
+		for (unsigned j = 0; j < d; ++j)
+			ans = ans * WIDTH + size_t(letters[j] - 1);
+		return ans;
+	}
+
+	/// the j-th letter (j in 0..d) of the word of degree d at position i within its level
+	static constexpr alg::LET letter(unsigned d, size_t i, unsigned j)
+	{
+		return alg::LET(1 + (i / level_size(d - j - 1)) % WIDTH);
+	}
+
+	/// level offsets, built at compile time (see basis_dimensions.h)
+	static constexpr basis_dimensions::degree_table<DEPTH> offsets = basis_dimensions::tensor_offsets<WIDTH, DEPTH>();
+
+	/// the position of a TENSOR word within its level
+	template <typename TENSOR>
+	static size_t index_in_level(typename TENSOR::KEY k)
+	{
+		size_t ans = 0;
+		for (; TENSOR::basis.degree(k) > 0; k = TENSOR::basis.rparent(k))
+			ans = ans * WIDTH + (TENSOR::basis.getfirstletter(k) - 1);
+		return ans;
+	}
+
+	/// the position of a TENSOR word in the dense buffer
+	template <typename TENSOR>
+	static size_t index(const typename TENSOR::KEY& k)
+	{
+		return offset(TENSOR::basis.degree(k)) + index_in_level<TENSOR>(k);
+	}
+
+	/// the degree of the word at position index < size() of the dense buffer
+	static unsigned degree(size_t index)
+	{
+		unsigned d = 0;
+		while (d < DEPTH && offset(d + 1) <= index)
+			++d;
+		return d;
+	}
+
+	/// the TENSOR word of degree d at position i within its level
+	template <typename TENSOR>
+	static typename TENSOR::KEY key(unsigned d, size_t i)
+	{
+		typename TENSOR::KEY ans;
+		for (unsigned j = d; j > 0; --j) {
+			size_t p = level_size(j - 1);
+			ans = ans * TENSOR::basis.keyofletter(alg::LET(1 + i / p));
+			i %= p;
+		}
+		return ans;
+	}
+};
+
+template <unsigned WIDTH, unsigned DEPTH>
+constexpr basis_dimensions::degree_table<DEPTH> tensor_layout<WIDTH, DEPTH>::offsets;
+
+/// accumulates the outer product of two dense levels: out[i * nb + j] += a[i] * b[j]
+/// if a is the degree m part of x and b the degree n part of y then out receives the
+/// a (x) b contribution to the degree m + n part of x * y; zero rows of a are skipped
+template <typename SCALAR>
+void outer_product_add(SCALAR* out, const SCALAR* a, size_t na, const SCALAR* b, size_t nb)
+{
+	for (size_t i = 0; i < na; ++i) {
+		const SCALAR ai = a[i];
+		if (ai == SCALAR(0))
+			continue;
+		SCALAR* row = out + i * nb;
+		for (size_t j = 0; j < nb; ++j)
+			row[j] += ai * b[j];
+	}
+}
+
+/// lhs = lhs * rhs truncated at DEPTH, computed in place from the top degree down
+/// degree d of the product only reads degrees 0..d of lhs, and degrees below d still hold
+/// their original values when degree d is overwritten, so no output buffer is needed.
+/// LHS and RHS expose level(d) as a pointer to the WIDTH^d coefficients of degree d;
+/// lhs and rhs must not share storage
+template <unsigned WIDTH, unsigned DEPTH, typename LHS, typename RHS>
+void multiply_inplace(LHS& lhs, const RHS& rhs)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	const auto unit = rhs.level(0)[0];
+	for (unsigned d = DEPTH + 1; d-- > 0;) {
+		auto out = lhs.level(d);
+		for (size_t j = 0; j < LAYOUT::level_size(d); ++j)
+			out[j] *= unit;
+		for (unsigned i = 0; i < d; ++i)
+			outer_product_add(out, lhs.level(i), LAYOUT::level_size(i), rhs.level(d - i), LAYOUT::level_size(d - i));
+	}
+}
+
+/// lhs = lhs * rhs truncated at DEPTH, in place, for a sparse TENSOR rhs such as exp(maps.l2t(increment))
+template <unsigned WIDTH, unsigned DEPTH, typename LHS, typename TENSOR>
+void multiply_inplace_sparse(LHS& lhs, const TENSOR& rhs)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	typedef typename TENSOR::SCALAR S;
+	const typename TENSOR::KEY empty;
+	const auto found = rhs.find(empty);
+	const S unit = (found == rhs.end()) ? S(0) : found->second;
+	for (unsigned d = DEPTH + 1; d-- > 0;) {
+		auto out = lhs.level(d);
+		for (size_t j = 0; j < LAYOUT::level_size(d); ++j)
+			out[j] *= unit;
+		for (const auto& k : rhs) {
+			const unsigned n = TENSOR::basis.degree(k.first);
+			if (n == 0 || n > d)
+				continue;
+			// the words u k.first with u of degree d - n
+			const size_t stride = LAYOUT::level_size(n);
+			const auto a = lhs.level(d - n);
+			auto o = out + LAYOUT::template index_in_level<TENSOR>(k.first);
+			for (size_t i = 0; i < LAYOUT::level_size(d - n); ++i)
+				o[i * stride] += a[i] * k.second;
+		}
+	}
+}
+
+/// x[0..WIDTH) <- the coordinates of a degree one lie element arg, the increments consumed by chen_update;
+/// throws std::invalid_argument if arg has a component of higher degree, which they would drop
+template <unsigned WIDTH, typename LIE>
+void degree_one_increment(const LIE& arg, double* x)
+{
+	std::fill(x, x + WIDTH, 0.);
+	for (const auto& k : arg) {
+		if (LIE::basis.degree(k.first) != 1)
+			throw std::invalid_argument("degree_one_increment: the increment has a component of degree above one");
+		x[k.first - 1] = double(k.second);
+	}
+}
+
+/// x[0..WIDTH) <- the increment of a raw path at row: the difference row[stride + j] - row[j] of consecutive
+/// points when is_path, else row[j] itself
+template <unsigned WIDTH>
+void raw_increment(const double* row, size_t stride, bool is_path, double* x)
+{
+	for (unsigned j = 0; j < WIDTH; ++j)
+		x[j] = is_path ? row[stride + j] - row[j] : row[j];
+}
+
+/// sig = sig * exp(x) truncated at DEPTH, in place, for a degree one increment x[0..WIDTH)
+/// new degree d is sum_i sig_i (x) x^(d-i) / (d-i)!, formed top down without exp(x) by the Horner recursion
+/// B_0 = sig_0, B_k = sig_k + B_(k-1) (x) x / (d-k+1), new sig_d = B_d, with B_k, k < d, held in scratch
+template <unsigned WIDTH, unsigned DEPTH, typename TENSOR_T, typename SCALAR>
+void chen_update(TENSOR_T& sig, const double* x, std::vector<SCALAR>& scratch)
+{
+	typedef tensor_layout<WIDTH, DEPTH> LAYOUT;
+	const size_t half = (DEPTH > 1) ? LAYOUT::level_size(DEPTH - 1) : 1;
+	scratch.resize(2 * half);
+	for (unsigned d = DEPTH; d >= 1; --d) {
+		const SCALAR* previous = sig.level(0);
+		for (unsigned k = 1; k <= d; ++k) {
+			SCALAR* next = (k == d) ? sig.level(d) : &scratch[(k % 2) * half];
+			const SCALAR* s = sig.level(k);
+			const SCALAR c = SCALAR(1) / SCALAR(d - k + 1);
+			for (size_t a = 0; a < LAYOUT::level_size(k - 1); ++a) {
+				const SCALAR pa = previous[a] * c;
+				for (unsigned b = 0; b < WIDTH; ++b)
+					next[a * WIDTH + b] = s[a * WIDTH + b] + pa * SCALAR(x[b]);
+			}
+			previous = next;
+		}
+	}
+}
@@ -27,6 +27,10 @@ Version 3. (See accompanying file License.txt)
 // a debugging tool - SHOW(X) outputs variable name X and its content to a stream (e.g. cout) 
 #include "SHOW.h"
 #include "time_and_details.h"
+#include "dense_tensor.h"
+#include "basis_dimensions.h"
+#include "group_like.h"
+#include "SigHelpers.h"
 
 
 // to allow redefinitions in other test modules
@@ -55,6 +59,8 @@ namespace {
 		typedef typename ALG::CBH CBH;
 		typedef typename ALG::S S;
 		typedef typename ALG::LET LET;
+		static const unsigned DEPTH = ALG::DEPTH;
+		static const unsigned ALPHABET_SIZE = ALG::ALPHABET_SIZE;
 
 		// state
 		mutable MAPS maps; // has cached state
@@ -224,6 +230,28 @@ namespace {
 		CHECK(exp(log(sig)) == sig);
 	}
 
+	TEST_FIXTURE(categorical_path, graded_exp_of_lie_element)
+	{
+		TEST_DETAILS();
+		auto begin = increments.cbegin();
+		auto end = increments.cend();
+		TENSOR sig = signature(begin, end);
+		LIE logsig = logsignature(begin, end);
+		TENSOR expected, ans;
+		std::cout << "exp(maps.l2t(logsig)): ";
+		{
+			timer exp_t;
+			expected = exp(maps.l2t(logsig));
+		}
+		std::cout << "graded exp of the lie element: ";
+		{
+			timer exp_t;
+			ans = ::lie_exp(logsig, *this);
+		}
+		CHECK(expected == ans);
+		CHECK(sig == ans);
+	}
+
 	TEST_FIXTURE(categorical_path, LIE_PRODUCT)
 	{
 		TEST_DETAILS();
@@ -250,6 +278,45 @@ namespace {
 		CHECK(inverse(exp(t1))* exp(t1) == TENSOR(S(1)));
 	}
 
+	TEST_FIXTURE(categorical_path, AntipodeInverse)
+	{
+		TEST_DETAILS();
+		auto begin = increments.cbegin();
+		auto end = increments.cend();
+		LIE l1 = logsignature(begin, end);
+		TENSOR g = exp(maps.l2t(l1));
+		TENSOR expected, ans;
+		std::cout << "inverse: ";
+		{
+			timer inverse_t;
+			expected = inverse(g);
+		}
+		std::cout << "antipode: ";
+		{
+			timer inverse_t;
+			ans = group_inverse(g);
+		}
+		CHECK(expected == ans);
+		CHECK(is_group_like(g));
+		CHECK(!is_group_like(TENSOR(g + g)));
+
+		// increments between observation times invert by the antipode through the type
+		auto middle = begin + (end - begin) / 2;
+		group_like<TENSOR> sig_s(signature(begin, middle)), sig_t(signature(begin, end));
+		CHECK(signature_increment(sig_s, sig_t) == signature(middle, end));
+		CHECK(inverse(sig_s) * sig_s == TENSOR(S(1)));
+
+		// the increments between several observation times from the signatures up to each
+		std::vector<group_like<TENSOR>> prefixes;
+		const ptrdiff_t every = 7;
+		for (auto t = begin + every; t <= end; t += every)
+			prefixes.push_back(::group_like_signature(begin, t, *this));
+		const std::vector<group_like<TENSOR>> steps = ::o_signature_increments(prefixes);
+		CHECK_EQUAL(prefixes.size(), steps.size());
+		for (size_t k = 0; k < steps.size(); ++k)
+			CHECK(steps[k] == signature(begin + k * every, begin + (k + 1) * every));
+	}
+
 	TEST_FIXTURE(uni_env, the_basis)
 	{
 		TEST_DETAILS();
@@ -274,6 +341,45 @@ namespace {
 		}
 	}
 	
+	TEST_FIXTURE(uni_env, compile_time_dimensions)
+	{
+		TEST_DETAILS();
+		typedef tensor_layout<ALPHABET_SIZE, DEPTH> LAYOUT;
+		typedef hall_layout<ALPHABET_SIZE, DEPTH> HALL;
+		// the dimensions asserted at run time in the lattice path tests
+		static_assert(ConstTensorDimension<5, 5>::ans == 3906, "tensor dimension");
+		static_assert(ConstHallDimension<5, 5>::ans == 829, "hall dimension");
+		static_assert(ConstTensorDimension<8, 6>::ans == 299593, "tensor dimension");
+		static_assert(tensor_layout<8, 6>::size() == 299593, "tensor layout");
+		static_assert(hall_layout<2, 6>::level_size(6) == 9, "witt formula");
+		static_assert(LAYOUT::size() == ConstTensorDimension<ALPHABET_SIZE, DEPTH>::ans, "tensor layout");
+		static_assert(HALL::size() == ConstHallDimension<ALPHABET_SIZE, DEPTH>::ans, "hall layout");
+		// a statically sized buffer
+		double buffer[LAYOUT::size()];
+		CHECK_EQUAL(TENSOR::basis.size(), sizeof(buffer) / sizeof(double));
+		CHECK_EQUAL(LIE::basis.size(), HALL::size());
+
+		// the Hall basis by degree
+		std::vector<size_t> hall_counts(DEPTH + 1, 0);
+		for (typename LIE::BASIS::KEY k = LIE::basis.begin(); k != LIE::basis.end(); k = LIE::basis.nextkey(k))
+			++hall_counts[LIE::basis.degree(k)];
+		for (unsigned d = 1; d <= DEPTH; ++d)
+			CHECK_EQUAL(hall_counts[d], HALL::level_size(d));
+
+		// the word <-> index maps agree with the basis
+		size_t position = 0;
+		for (typename TENSOR::BASIS::KEY k = TENSOR::basis.begin(); k != TENSOR::basis.end(); k = TENSOR::basis.nextkey(k), ++position) {
+			const unsigned d = TENSOR::basis.degree(k);
+			const size_t i = LAYOUT::index_in_level<TENSOR>(k);
+			CHECK_EQUAL(position, LAYOUT::offset(d) + i);
+			LET letters[DEPTH];
+			for (unsigned j = 0; j < d; ++j)
+				letters[j] = LAYOUT::letter(d, i, j);
+			CHECK_EQUAL(i, LAYOUT::word_index(letters, d));
+			CHECK(LAYOUT::key<TENSOR>(d, i) == k);
+		}
+	}
+
 	TEST_FIXTURE(uni_env, constructors)
 	{
 		TEST_DETAILS();
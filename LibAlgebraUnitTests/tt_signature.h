@@ -0,0 +1,388 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <stddef.h> //size_t
+#include "tensor_layout.h"
+
+// low rank (tensor-train) signatures
+//
+// the degree n part of a tensor over WIDTH letters is held in tensor-train form
+//     T(a_1,...,a_n) = G_1(a_1) G_2(a_2) ... G_n(a_n)
+// where G_k(a) is an r_(k-1) x r_k matrix and r_0 = r_n = 1. Storage is sum_k r_(k-1) WIDTH r_k
+// rather than WIDTH^n, and the ranks are kept small by truncated svd rounding.
+
+/// thin svd of the m x n row major matrix a = u diag(s) vt by one sided jacobi rotations
+/// u is m x k, s has k entries in decreasing order and vt is k x n where k = min(m, n)
+inline void jacobi_svd(size_t m, size_t n, const std::vector<double>& a, std::vector<double>& u, std::vector<double>& s, std::vector<double>& vt)
+{
+	if (m < n) {
+		// a^T = u' s vt' so a = vt'^T s u'^T
+		std::vector<double> at(n * m), ut, vtt;
+		for (size_t i = 0; i < m; ++i)
+			for (size_t j = 0; j < n; ++j)
+				at[j * m + i] = a[i * n + j];
+		jacobi_svd(n, m, at, ut, s, vtt);
+		u.assign(m * m, 0.);
+		vt.assign(m * n, 0.);
+		for (size_t i = 0; i < m; ++i)
+			for (size_t j = 0; j < m; ++j)
+				u[i * m + j] = vtt[j * m + i];
+		for (size_t i = 0; i < m; ++i)
+			for (size_t j = 0; j < n; ++j)
+				vt[i * n + j] = ut[j * m + i];
+		return;
+	}
+	// m >= n: orthogonalise the columns of w = a v
+	std::vector<double> w(a), v(n * n, 0.);
+	for (size_t i = 0; i < n; ++i)
+		v[i * n + i] = 1.;
+	for (int sweep = 0; sweep < 60; ++sweep) {
+		double off = 0.;
+		for (size_t p = 0; p + 1 < n; ++p)
+			for (size_t q = p + 1; q < n; ++q) {
+				double alpha = 0., beta = 0., gamma = 0.;
+				for (size_t i = 0; i < m; ++i) {
+					alpha += w[i * n + p] * w[i * n + p];
+					beta += w[i * n + q] * w[i * n + q];
+					gamma += w[i * n + p] * w[i * n + q];
+				}
+				if (gamma == 0. || std::fabs(gamma) <= 1e-15 * std::sqrt(alpha * beta))
+					continue;
+				off = std::max(off, std::fabs(gamma) / std::sqrt(alpha * beta));
+				const double zeta = (beta - alpha) / (2. * gamma);
+				const double t = ((zeta >= 0.) ? 1. : -1.) / (std::fabs(zeta) + std::sqrt(1. + zeta * zeta));
+				const double c = 1. / std::sqrt(1. + t * t), sn = c * t;
+				for (size_t i = 0; i < m; ++i) {
+					const double wp = w[i * n + p], wq = w[i * n + q];
+					w[i * n + p] = c * wp - sn * wq;
+					w[i * n + q] = sn * wp + c * wq;
+				}
+				for (size_t i = 0; i < n; ++i) {
+					const double vp = v[i * n + p], vq = v[i * n + q];
+					v[i * n + p] = c * vp - sn * vq;
+					v[i * n + q] = sn * vp + c * vq;
+				}
+			}
+		if (off <= 1e-15)
+			break;
+	}
+	// singular values are the column norms, sorted decreasing
+	std::vector<double> norms(n, 0.);
+	for (size_t j = 0; j < n; ++j) {
+		for (size_t i = 0; i < m; ++i)
+			norms[j] += w[i * n + j] * w[i * n + j];
+		norms[j] = std::sqrt(norms[j]);
+	}
+	std::vector<size_t> order(n);
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::sort(order.begin(), order.end(), [&norms](size_t l, size_t r) {return norms[l] > norms[r]; });
+	u.assign(m * n, 0.);
+	s.assign(n, 0.);
+	vt.assign(n * n, 0.);
+	for (size_t k = 0; k < n; ++k) {
+		const size_t j = order[k];
+		s[k] = norms[j];
+		for (size_t i = 0; i < m; ++i)
+			u[i * n + k] = (norms[j] > 0.) ? w[i * n + j] / norms[j] : 0.;
+		for (size_t i = 0; i < n; ++i)
+			vt[k * n + i] = v[i * n + j];
+	}
+}
+
+/// tt_train - a homogeneous tensor of degree cores.size() over WIDTH letters in tensor-train form
+template <unsigned WIDTH>
+struct tt_train
+{
+	/// an r0 x WIDTH x r1 core; entry (i, a, j) is at (i * WIDTH + a) * r1 + j
+	struct core
+	{
+		size_t r0, r1;
+		std::vector<double> data;
+		core(size_t left, size_t right) : r0(left), r1(right), data(left * WIDTH * right, 0.) {}
+		double& operator()(size_t i, size_t a, size_t j) { return data[(i * WIDTH + a) * r1 + j]; }
+		double operator()(size_t i, size_t a, size_t j) const { return data[(i * WIDTH + a) * r1 + j]; }
+	};
+
+	std::vector<core> cores;
+
+	size_t degree() const { return cores.size(); }
+
+	/// the number of stored coefficients
+	size_t storage() const
+	{
+		size_t ans = 0;
+		for (const core& g : cores)
+			ans += g.data.size();
+		return ans;
+	}
+
+	/// the largest internal rank
+	size_t rank() const
+	{
+		size_t ans = 1;
+		for (const core& g : cores)
+			ans = std::max(ans, g.r1);
+		return ans;
+	}
+
+	/// the rank one tensor x (x) x (x) ... (x) x (n factors) times scale
+	static tt_train power(const double* x, size_t n, double scale)
+	{
+		tt_train ans;
+		for (size_t k = 0; k < n; ++k) {
+			ans.cores.emplace_back(1, 1);
+			for (size_t a = 0; a < WIDTH; ++a)
+				ans.cores.back()(0, a, 0) = x[a] * ((k == 0) ? scale : 1.);
+		}
+		return ans;
+	}
+
+	/// the coefficient of the word (a_1,...,a_n) with letters in 1..WIDTH
+	template <typename LETTER_ITERATOR>
+	double coordinate(LETTER_ITERATOR word) const
+	{
+		std::vector<double> row(1, 1.), next;
+		for (const core& g : cores) {
+			const size_t a = size_t(*word++) - 1;
+			next.assign(g.r1, 0.);
+			for (size_t i = 0; i < g.r0; ++i)
+				for (size_t j = 0; j < g.r1; ++j)
+					next[j] += row[i] * g(i, a, j);
+			row.swap(next);
+		}
+		return row[0];
+	}
+
+	/// the euclidean inner product with a tensor of the same degree
+	friend double dot(const tt_train& lhs, const tt_train& rhs)
+	{
+		// m is the r_k(lhs) x r_k(rhs) contraction of the first k cores
+		std::vector<double> m(1, 1.), t, next;
+		for (size_t k = 0; k < lhs.cores.size(); ++k) {
+			const core& a = lhs.cores[k];
+			const core& b = rhs.cores[k];
+			// t(p, c, j) = sum_i m(i, p) a(i, c, j)
+			t.assign(b.r0 * WIDTH * a.r1, 0.);
+			for (size_t i = 0; i < a.r0; ++i)
+				for (size_t p = 0; p < b.r0; ++p)
+					for (size_t c = 0; c < WIDTH; ++c)
+						for (size_t j = 0; j < a.r1; ++j)
+							t[(p * WIDTH + c) * a.r1 + j] += m[i * b.r0 + p] * a(i, c, j);
+			// next(j, l) = sum_(p, c) t(p, c, j) b(p, c, l)
+			next.assign(a.r1 * b.r1, 0.);
+			for (size_t p = 0; p < b.r0; ++p)
+				for (size_t c = 0; c < WIDTH; ++c)
+					for (size_t j = 0; j < a.r1; ++j)
+						for (size_t l = 0; l < b.r1; ++l)
+							next[j * b.r1 + l] += t[(p * WIDTH + c) * a.r1 + j] * b(p, c, l);
+			m.swap(next);
+		}
+		return m[0];
+	}
+
+	/// the concatenation product lhs (x) rhs; exact with ranks joined at rank one
+	friend tt_train concatenate(const tt_train& lhs, const tt_train& rhs)
+	{
+		tt_train ans(lhs);
+		ans.cores.insert(ans.cores.end(), rhs.cores.begin(), rhs.cores.end());
+		return ans;
+	}
+
+	/// adds a tensor of the same degree (n > 0); the ranks add
+	tt_train& operator+=(const tt_train& rhs)
+	{
+		const size_t n = cores.size();
+		for (size_t k = 0; k < n; ++k) {
+			const core& a = cores[k];
+			const core& b = rhs.cores[k];
+			// block diagonal, except a row at the start and a column at the end
+			const size_t r0 = (k == 0) ? 1 : a.r0 + b.r0;
+			const size_t r1 = (k + 1 == n) ? 1 : a.r1 + b.r1;
+			core c(r0, r1);
+			const size_t bi = (k == 0) ? 0 : a.r0;
+			const size_t bj = (k + 1 == n) ? 0 : a.r1;
+			for (size_t i = 0; i < a.r0; ++i)
+				for (size_t x = 0; x < WIDTH; ++x)
+					for (size_t j = 0; j < a.r1; ++j)
+						c(i, x, j) += a(i, x, j);
+			for (size_t i = 0; i < b.r0; ++i)
+				for (size_t x = 0; x < WIDTH; ++x)
+					for (size_t j = 0; j < b.r1; ++j)
+						c(bi + i, x, bj + j) += b(i, x, j);
+			cores[k] = c;
+		}
+		return *this;
+	}
+
+	/// truncated svd rounding with relative accuracy eps and ranks at most max_rank
+	/// returns the frobenius norm of the discarded part
+	double round(double eps, size_t max_rank)
+	{
+		const size_t n = cores.size();
+		if (n < 2)
+			return 0.;
+		std::vector<double> u, s, vt;
+		// right to left orthogonalisation: core k becomes row orthonormal as an r0 x (WIDTH r1) matrix
+		for (size_t k = n - 1; k > 0; --k) {
+			core& g = cores[k];
+			core& h = cores[k - 1];
+			jacobi_svd(g.r0, WIDTH * g.r1, g.data, u, s, vt);
+			const size_t r = s.size();
+			core q(r, g.r1);
+			std::copy(vt.begin(), vt.begin() + r * WIDTH * g.r1, q.data.begin());
+			// h = h u diag(s)
+			core p(h.r0, r);
+			for (size_t i = 0; i < h.r0 * WIDTH; ++i)
+				for (size_t j = 0; j < r; ++j) {
+					double acc = 0.;
+					for (size_t l = 0; l < h.r1; ++l)
+						acc += h.data[i * h.r1 + l] * u[l * r + j] * s[j];
+					p.data[i * r + j] = acc;
+				}
+			g = q;
+			h = p;
+		}
+		// the norm now sits in the first core
+		double norm = 0.;
+		for (double x : cores[0].data)
+			norm += x * x;
+		const double delta2 = eps * eps * norm / double(n - 1);
+		double discarded2 = 0.;
+		// left to right truncation
+		for (size_t k = 0; k + 1 < n; ++k) {
+			core& g = cores[k];
+			core& h = cores[k + 1];
+			const size_t rows = g.r0 * WIDTH;
+			jacobi_svd(rows, g.r1, g.data, u, s, vt);
+			const size_t full = s.size();
+			size_t r = full;
+			double tail = 0.;
+			while (r > 1 && (tail + s[r - 1] * s[r - 1] <= delta2 || r > max_rank)) {
+				--r;
+				tail += s[r] * s[r];
+			}
+			discarded2 += tail;
+			core q(g.r0, r);
+			for (size_t i = 0; i < rows; ++i)
+				for (size_t j = 0; j < r; ++j)
+					q.data[i * r + j] = u[i * full + j];
+			// h = diag(s) vt h, restricted to the leading r rows
+			core p(r, h.r1);
+			for (size_t i = 0; i < r; ++i)
+				for (size_t l = 0; l < g.r1; ++l) {
+					const double svt = s[i] * vt[i * g.r1 + l];
+					if (svt == 0.)
+						continue;
+					for (size_t j = 0; j < WIDTH * h.r1; ++j)
+						p.data[i * WIDTH * h.r1 + j] += svt * h.data[l * WIDTH * h.r1 + j];
+				}
+			g = q;
+			h = p;
+		}
+		return std::sqrt(discarded2);
+	}
+};
+
+/// tt_signature - a truncated signature held level by level in tensor-train form
+///
+/// increments are of degree one (a vector in R^WIDTH), as in brown_path_increments and categorical_path.
+/// After each Chen product every level is rounded to relative accuracy eps with ranks at most max_rank
+/// so memory scales with the ranks rather than with WIDTH^DEPTH; discarded() accumulates the
+/// frobenius norm of everything that rounding has thrown away.
+///
+template <unsigned WIDTH, unsigned DEPTH>
+class tt_signature
+{
+public:
+	typedef tt_train<WIDTH> TRAIN;
+
+	// constructor - the signature of the constant path
+	tt_signature(double eps = 1e-12, size_t max_rank = size_t(-1))
+		: eps(eps), max_rank(max_rank), unit(1.), levels(DEPTH), lost(0.)
+	{
+		static const double zero[WIDTH] = {};
+		for (unsigned n = 1; n <= DEPTH; ++n)
+			levels[n - 1] = TRAIN::power(zero, n, 0.);
+	}
+
+	/// the degree n part, n >= 1
+	const TRAIN& level(unsigned n) const { return levels[n - 1]; }
+
+	/// Chen's identity: this = this (x) exp(x) for an increment x in R^WIDTH
+	tt_signature& operator*=(const double* x)
+	{
+		// top down so that the lower levels are still those of the old signature
+		for (unsigned n = DEPTH; n >= 1; --n) {
+			// S_0 exp(x)_n
+			double factorial = 1.;
+			for (unsigned m = 2; m <= n; ++m)
+				factorial *= m;
+			TRAIN ans = TRAIN::power(x, n, unit / factorial);
+			// S_i (x) exp(x)_(n-i)
+			for (unsigned i = 1; i <= n; ++i) {
+				factorial = 1.;
+				for (unsigned m = 2; m <= n - i; ++m)
+					factorial *= m;
+				if (i == n)
+					ans += levels[i - 1];
+				else
+					ans += concatenate(levels[i - 1], TRAIN::power(x, n - i, 1. / factorial));
+			}
+			lost += ans.round(eps, max_rank);
+			levels[n - 1] = ans;
+		}
+		return *this;
+	}
+
+	/// the coefficient of the word (a_1,...,a_n), letters in 1..WIDTH
+	template <typename LETTER_ITERATOR>
+	double coordinate(LETTER_ITERATOR begin, LETTER_ITERATOR end) const
+	{
+		const size_t n = size_t(end - begin);
+		return (n == 0) ? unit : levels[n - 1].coordinate(begin);
+	}
+
+	/// the euclidean inner product of two truncated signatures
+	friend double dot(const tt_signature& lhs, const tt_signature& rhs)
+	{
+		double ans = lhs.unit * rhs.unit;
+		for (unsigned n = 1; n <= DEPTH; ++n)
+			ans += dot(lhs.levels[n - 1], rhs.levels[n - 1]);
+		return ans;
+	}
+
+	/// the number of stored coefficients
+	size_t storage() const
+	{
+		size_t ans = 1;
+		for (const TRAIN& t : levels)
+			ans += t.storage();
+		return ans;
+	}
+
+	/// the accumulated frobenius norm discarded by rounding
+	double discarded() const { return lost; }
+
+private:
+	double eps;
+	size_t max_rank;
+	double unit;
+	std::vector<TRAIN> levels;
+	double lost;
+};
+
+/// computes the tensor-train signature of an iterable sequence of degree one lie elements;
+/// throws std::invalid_argument on an increment of higher degree
+template<typename ITERATOR_T, typename FRAMEWORK>
+tt_signature<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> tt_signature_of(ITERATOR_T begin, ITERATOR_T end, const FRAMEWORK& context, double eps = 1e-12, size_t max_rank = size_t(-1))
+{
+	tt_signature<FRAMEWORK::ALPHABET_SIZE, FRAMEWORK::DEPTH> signature(eps, max_rank);
+	double x[FRAMEWORK::ALPHABET_SIZE];
+	for (ITERATOR_T i = begin; i != end; i++) {
+		degree_one_increment<FRAMEWORK::ALPHABET_SIZE>(*i, x);
+		signature *= x;
+	}
+	return signature;
+}